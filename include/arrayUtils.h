@@ -45,6 +45,13 @@ public:
         return elements[index];
     }
 
+    constexpr inline const type& operator[](size_t index) const
+    {
+        if (index >= length) throw std::runtime_error("Cannot retrieve data outside of the array.");
+
+        return elements[index];
+    }
+
 private:
     size_t length = 0;
 
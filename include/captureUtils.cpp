@@ -0,0 +1,298 @@
+
+#include "captureUtils.h"
+
+#include <chrono>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+captureWriter::captureWriter(const std::string& path, const size_t Max_pending)
+	: file(nullptr), max_pending(Max_pending), closing(false), recorded(0), dropped_records(0), written(0), write_failed(false)
+{
+	file = std::fopen(path.c_str(), "ab");
+
+	if (!file) throw exceptions::exception("Could not open the capture file: " + path);
+
+	std::fseek(file, 0, SEEK_END);
+
+	if (std::ftell(file) == 0)
+	{
+		char header[CAPTURE_FILE_HEADER_SIZE] = {};
+
+		std::memcpy(header, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+		std::memcpy(header + 8, &CAPTURE_VERSION, sizeof(CAPTURE_VERSION));
+
+		if (std::fwrite(header, 1, CAPTURE_FILE_HEADER_SIZE, file) != CAPTURE_FILE_HEADER_SIZE)
+		{
+			std::fclose(file);
+
+			throw exceptions::exception("Could not write the capture file header: " + path);
+		}
+
+		written.store(CAPTURE_FILE_HEADER_SIZE, std::memory_order_relaxed);
+	}
+
+	pending.reserve(CAPTURE_UTILS_FLUSH_SIZE * 2);
+	writing.reserve(CAPTURE_UTILS_FLUSH_SIZE * 2);
+
+	writer_thread = std::thread(&captureWriter::writeRecords, this);
+}
+
+captureWriter::captureWriter(const captureWriter& other_writer)
+{
+	throw std::runtime_error("captureWriter type doesn't support copy construction.");
+}
+
+captureWriter::~captureWriter()
+{
+	close();
+}
+
+captureWriter& captureWriter::operator=(const captureWriter& other_writer)
+{
+	throw std::runtime_error("captureWriter type doesn't support item assignment.");
+}
+
+bool captureWriter::record(const int64_t timestamp_ns, const char opcode, const std::string_view payload)
+{
+	char header[CAPTURE_RECORD_HEADER_SIZE] = {};
+
+	const uint32_t length = static_cast<uint32_t>(payload.size());
+
+	std::memcpy(header, &timestamp_ns, sizeof(timestamp_ns));
+	std::memcpy(header + 8, &length, sizeof(length));
+
+	header[12] = opcode;
+
+	bool wake_writer = false;
+
+	{
+		std::lock_guard<std::mutex> lock(pending_mutex);
+
+		if (closing || write_failed.load(std::memory_order_relaxed) || payload.size() > UINT32_MAX ||
+			pending.size() + CAPTURE_RECORD_HEADER_SIZE + payload.size() > max_pending)
+		{
+			dropped_records.fetch_add(1, std::memory_order_relaxed);
+
+			return false;
+		}
+
+		pending.append(header, CAPTURE_RECORD_HEADER_SIZE);
+		pending.append(payload.data(), payload.size());
+
+		wake_writer = pending.size() >= CAPTURE_UTILS_FLUSH_SIZE;
+	}
+
+	recorded.fetch_add(1, std::memory_order_relaxed);
+
+	if (wake_writer) pending_ready.notify_one();
+
+	return true;
+}
+
+void captureWriter::close()
+{
+	{
+		std::lock_guard<std::mutex> lock(pending_mutex);
+
+		closing = true;
+	}
+
+	pending_ready.notify_one();
+
+	if (writer_thread.joinable()) writer_thread.join();
+
+	if (file)
+	{
+		std::fclose(file);
+
+		file = nullptr;
+	}
+}
+
+void captureWriter::writeRecords()
+{
+	while (true)
+	{
+		bool last_pass;
+
+		{
+			std::unique_lock<std::mutex> lock(pending_mutex);
+
+			pending_ready.wait_for(lock, std::chrono::milliseconds(CAPTURE_UTILS_FLUSH_MS), [this]() { return closing || pending.size() >= CAPTURE_UTILS_FLUSH_SIZE; });
+
+			//the recording side keeps the capacity writing had, so neither buffer reallocates once both have grown
+			pending.swap(writing);
+
+			last_pass = closing;
+		}
+
+		if (!writing.empty())
+		{
+			if (std::fwrite(writing.data(), 1, writing.size(), file) != writing.size() || std::fflush(file) != 0) write_failed.store(true, std::memory_order_relaxed);
+			else written.fetch_add(writing.size(), std::memory_order_relaxed);
+
+			writing.clear();
+		}
+
+		if (last_pass) return;
+	}
+}
+
+captureReader::captureReader(const std::string& path) : data(nullptr), file_size(0), position(CAPTURE_FILE_HEADER_SIZE)
+{
+#ifdef _WIN32
+
+	file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file_handle == INVALID_HANDLE_VALUE) throw exceptions::exception("Could not open the capture file: " + path);
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(file_handle, &size))
+	{
+		CloseHandle(file_handle);
+
+		throw exceptions::exception("Could not read the size of the capture file: " + path);
+	}
+
+	file_size = static_cast<size_t>(size.QuadPart);
+	mapping_handle = nullptr;
+
+	if (file_size >= CAPTURE_FILE_HEADER_SIZE)
+	{
+		mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (mapping_handle) data = static_cast<const char*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+
+		if (!data)
+		{
+			if (mapping_handle) CloseHandle(mapping_handle);
+
+			CloseHandle(file_handle);
+
+			throw exceptions::exception("Could not map the capture file: " + path);
+		}
+	}
+
+#else
+
+	int descriptor = open(path.c_str(), O_RDONLY);
+
+	if (descriptor < 0) throw exceptions::exception("Could not open the capture file: " + path);
+
+	struct stat file_status;
+
+	if (fstat(descriptor, &file_status) != 0)
+	{
+		::close(descriptor);
+
+		throw exceptions::exception("Could not read the size of the capture file: " + path);
+	}
+
+	file_size = static_cast<size_t>(file_status.st_size);
+
+	if (file_size >= CAPTURE_FILE_HEADER_SIZE)
+	{
+		void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+		if (mapping == MAP_FAILED)
+		{
+			::close(descriptor);
+
+			throw exceptions::exception("Could not map the capture file: " + path);
+		}
+
+		//records are read front to back
+		madvise(mapping, file_size, MADV_SEQUENTIAL);
+
+		data = static_cast<const char*>(mapping);
+	}
+
+	//the mapping stays valid after the descriptor is closed
+	::close(descriptor);
+
+#endif
+
+	if (!data || std::memcmp(data, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0)
+	{
+		unmap();
+
+		throw exceptions::exception("Not a capture file: " + path);
+	}
+
+	uint32_t version;
+
+	std::memcpy(&version, data + 8, sizeof(version));
+
+	if (version != CAPTURE_VERSION)
+	{
+		unmap();
+
+		throw exceptions::exception("Unsupported capture file version " + std::to_string(version) + ": " + path);
+	}
+}
+
+captureReader::captureReader(const captureReader& other_reader)
+{
+	throw std::runtime_error("captureReader type doesn't support copy construction.");
+}
+
+captureReader::~captureReader()
+{
+	unmap();
+}
+
+captureReader& captureReader::operator=(const captureReader& other_reader)
+{
+	throw std::runtime_error("captureReader type doesn't support item assignment.");
+}
+
+void captureReader::unmap() noexcept
+{
+#ifdef _WIN32
+
+	if (data) UnmapViewOfFile(data);
+	if (mapping_handle) CloseHandle(mapping_handle);
+	if (file_handle != INVALID_HANDLE_VALUE) CloseHandle(file_handle);
+
+	mapping_handle = nullptr;
+	file_handle = INVALID_HANDLE_VALUE;
+
+#else
+
+	if (data) munmap(const_cast<char*>(data), file_size);
+
+#endif
+
+	data = nullptr;
+}
+
+bool captureReader::next(captureRecord& record)
+{
+	if (file_size - position < CAPTURE_RECORD_HEADER_SIZE) return false;
+
+	uint32_t length;
+
+	std::memcpy(&record.timestamp_ns, data + position, sizeof(record.timestamp_ns));
+	std::memcpy(&length, data + position + 8, sizeof(length));
+
+	if (file_size - position - CAPTURE_RECORD_HEADER_SIZE < length) return false;
+
+	record.opcode = data[position + 12];
+	record.payload = std::string_view(data + position + CAPTURE_RECORD_HEADER_SIZE, length);
+
+	position += CAPTURE_RECORD_HEADER_SIZE + length;
+
+	return true;
+}
+
+void captureReader::rewind() noexcept
+{
+	position = CAPTURE_FILE_HEADER_SIZE;
+}
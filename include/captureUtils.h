@@ -0,0 +1,142 @@
+
+//append-only binary capture of received websocket messages with their receive timestamps and a zero-copy reader for the captured files
+
+#ifndef CAPTURE_UTILS_H
+#define CAPTURE_UTILS_H
+
+#define CAPTURE_UTILS_FLUSH_SIZE 65536 //the writing thread is woken once this many bytes are waiting
+#define CAPTURE_UTILS_FLUSH_MS 100 //otherwise waiting records are written at least this often
+#define CAPTURE_UTILS_MAX_PENDING 67108864 //records are dropped (and counted) rather than buffered beyond this many bytes
+
+#include "exceptUtils.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+/*
+file layout - every integer is in host byte order (little endian on every supported platform)
+
+file header (16 bytes)
+	char magic[8] - "WSCAP\0\0\0"
+	uint32_t version - CAPTURE_VERSION
+	uint32_t reserved
+
+record header (16 bytes) followed by length bytes of payload
+	int64_t timestamp_ns - nanoseconds since the epoch when the message was received
+	uint32_t length
+	uint8_t opcode - websocket opcode of the message (text, binary, ping, pong or close)
+	uint8_t reserved[3]
+
+records are not aligned - the reader copies headers out of the mapping and hands payloads out as views
+*/
+
+constexpr char CAPTURE_MAGIC[8] = { 'W', 'S', 'C', 'A', 'P', 0, 0, 0 };
+constexpr uint32_t CAPTURE_VERSION = 1;
+constexpr size_t CAPTURE_FILE_HEADER_SIZE = 16;
+constexpr size_t CAPTURE_RECORD_HEADER_SIZE = 16;
+
+struct captureRecord
+{
+	int64_t timestamp_ns;
+	char opcode;
+
+	std::string_view payload;
+};
+
+/*
+appends records to a capture file without doing any file io on the calling thread
+
+record copies the header and payload into a pending buffer under a mutex that is only ever held for a copy or a swap ...
+... and a writing thread swaps the pending buffer out and writes it - so the caller never waits on the disk
+if the disk falls behind by more than max_pending bytes, records are dropped and counted instead of stalling the caller
+an existing file is appended to - a new or empty file gets the file header first
+
+close writes whatever is waiting and joins the thread (the destructor calls it)
+*/
+
+class captureWriter
+{
+public:
+	captureWriter(const std::string&, const size_t = CAPTURE_UTILS_MAX_PENDING); //path, max_pending
+	captureWriter(const captureWriter&);
+	~captureWriter();
+
+	captureWriter& operator=(const captureWriter&);
+
+	bool record(const int64_t, const char, const std::string_view); //timestamp, opcode, payload - returns false if the record was dropped
+	void close();
+
+	inline uint64_t records() const noexcept { return recorded.load(std::memory_order_relaxed); } //records accepted
+	inline uint64_t dropped() const noexcept { return dropped_records.load(std::memory_order_relaxed); } //records dropped because the buffer was full or writing failed
+	inline uint64_t bytes_written() const noexcept { return written.load(std::memory_order_relaxed); } //bytes that reached the file
+	inline bool failed() const noexcept { return write_failed.load(std::memory_order_relaxed); } //a write to the file failed - later records are dropped
+
+private:
+	void writeRecords();
+
+	std::FILE* file;
+
+	size_t max_pending;
+
+	std::mutex pending_mutex;
+	std::condition_variable pending_ready;
+
+	std::string pending; //filled by record
+	std::string writing; //owned by the writing thread
+
+	bool closing;
+
+	std::atomic<uint64_t> recorded;
+	std::atomic<uint64_t> dropped_records;
+	std::atomic<uint64_t> written;
+	std::atomic<bool> write_failed;
+
+	std::thread writer_thread;
+};
+
+/*
+maps a capture file into memory and iterates its records - the payload views point into the mapping and stay valid until the reader is destroyed
+a record cut short at the end of the file (a capture that was still being written or was not closed) ends the iteration
+*/
+
+class captureReader
+{
+public:
+	captureReader(const std::string&);
+	captureReader(const captureReader&);
+	~captureReader();
+
+	captureReader& operator=(const captureReader&);
+
+	bool next(captureRecord&); //returns false once there are no more complete records
+	void rewind() noexcept;
+
+	inline size_t size() const noexcept { return file_size; } //bytes in the mapping
+
+private:
+	void unmap() noexcept;
+
+	const char* data;
+
+	size_t file_size;
+	size_t position;
+
+#ifdef _WIN32
+
+	HANDLE file_handle;
+	HANDLE mapping_handle;
+
+#endif
+};
+
+#endif
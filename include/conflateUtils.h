@@ -0,0 +1,187 @@
+
+//keep only the latest update per key for a consumer that falls behind - one producer thread, one consumer thread, and no locks
+
+#ifndef CONFLATE_UTILS_H
+#define CONFLATE_UTILS_H
+
+#include "sumapUtils.h"
+#include "spscUtils.h"
+#include "statUtils.h"
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+//one key's latest value - each slot has its own cache line so the producer writing one key never slows the consumer reading another
+template <typename keyDataType, typename valueDataType>
+struct alignas(SPSC_UTILS_CACHE_LINE) conflatingSlot
+{
+    std::atomic<uint64_t> sequence{ 0 }; //odd while the producer is writing value
+    std::atomic<bool> dirty{ false }; //an update is waiting and the slot's index is in the arrival queue
+
+    valueDataType value;
+
+    keyDataType key; //set once by initializeKeys
+    size_t index = 0; //position of the slot in the map - what the arrival queue carries
+
+    uint64_t delivered_sequence = 0; //consumer only - sequence of the last value handed out
+};
+
+/*
+a latest-value buffer keyed by symbol (or anything staticUnorderedMap can hash)
+update overwrites the key's slot, and only a key that was clean is put on the arrival queue ...
+... so try_pop hands out keys in the order they first became dirty, each with the newest value written since it was last popped
+updates replaced before the consumer got to them are counted as conflated - updates() == delivered() + conflated() once pending() is 0
+
+each slot is a seqlock - the producer never waits and the consumer copies the value again if the producer was writing it at the same time ...
+... which is why values must be trivially copyable (prices, sizes, and timestamps rather than strings)
+keys are fixed by initializeKeys before either thread starts, and updates for any other key are refused
+*/
+
+template <typename keyDataType, typename valueDataType, size_t N, size_t B>
+class conflatingQueue
+{
+public:
+    static_assert(std::is_trivially_copyable<valueDataType>::value, "conflatingQueue values are copied while they may be written so they must be trivially copyable.");
+
+    conflatingQueue();
+    conflatingQueue(const conflatingQueue&);
+    ~conflatingQueue();
+
+    conflatingQueue& operator=(const conflatingQueue&);
+
+    //takes any container that can be iterated with a range-based for loop
+    inline void initializeKeys(auto& range_based_container);
+
+    //producer side
+    inline bool update(const keyDataType&, const valueDataType&); //overwrite the key's pending value - false if the key was not initialized
+
+    //consumer side
+    inline bool try_pop(valueDataType&); //copy out the latest value of the key that became dirty first - false if no key is dirty
+    inline const keyDataType& last_key() const noexcept { return last_slot->key; } //key of the value try_pop returned last
+
+    inline size_t pending() const noexcept { return arrivals.size(); } //keys with an update waiting
+    inline uint64_t updates() const noexcept { return updated.get(); }
+    inline uint64_t conflated() const noexcept { return overwritten.get() + skipped.get(); } //updates replaced before the consumer read them
+    inline uint64_t delivered() const noexcept { return popped.get(); }
+
+private:
+    typedef conflatingSlot<keyDataType, valueDataType> slotType;
+
+    staticUnorderedMap<keyDataType, slotType, N, B> slots;
+    spscQueue<size_t, std::bit_ceil(N)> arrivals; //indices of dirty slots in the order they became dirty - a slot is queued at most once so it never fills
+
+    const slotType* last_slot;
+
+    statCounter updated; //written by the producer
+    statCounter overwritten;
+    statCounter popped; //written by the consumer
+    statCounter skipped;
+};
+
+template <typename keyDataType, typename valueDataType, size_t N, size_t B>
+conflatingQueue<keyDataType, valueDataType, N, B>::conflatingQueue() : last_slot(slots.begin()) {}
+
+template <typename keyDataType, typename valueDataType, size_t N, size_t B>
+conflatingQueue<keyDataType, valueDataType, N, B>::conflatingQueue(const conflatingQueue&)
+{
+    throw std::runtime_error("conflatingQueue type doesn't support copy construction.");
+}
+
+template <typename keyDataType, typename valueDataType, size_t N, size_t B>
+conflatingQueue<keyDataType, valueDataType, N, B>::~conflatingQueue() {}
+
+template <typename keyDataType, typename valueDataType, size_t N, size_t B>
+conflatingQueue<keyDataType, valueDataType, N, B>& conflatingQueue<keyDataType, valueDataType, N, B>::operator=(const conflatingQueue&)
+{
+    throw std::runtime_error("conflatingQueue type doesn't support item assignment.");
+}
+
+template <typename keyDataType, typename valueDataType, size_t N, size_t B>
+inline void conflatingQueue<keyDataType, valueDataType, N, B>::initializeKeys(auto& range_based_container)
+{
+    slots.initializeKeys(range_based_container);
+
+    for (const keyDataType& key : range_based_container)
+    {
+        slotType* slot = slots.find(key);
+
+        slot->key = key;
+        slot->index = static_cast<size_t>(slot - slots.begin());
+    }
+}
+
+template <typename keyDataType, typename valueDataType, size_t N, size_t B>
+inline bool conflatingQueue<keyDataType, valueDataType, N, B>::update(const keyDataType& key, const valueDataType& value)
+{
+    slotType* slot = slots.find(key);
+
+    if (slot == nullptr) return false;
+
+    //only this thread writes the sequence so it can be read relaxed
+    uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->value = value;
+
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+
+    updated.add(1);
+
+    //a key that is already dirty keeps its place in the arrival order
+    if (slot->dirty.exchange(true, std::memory_order_acq_rel)) overwritten.add(1);
+    else arrivals.try_push(slot->index);
+
+    return true;
+}
+
+template <typename keyDataType, typename valueDataType, size_t N, size_t B>
+inline bool conflatingQueue<keyDataType, valueDataType, N, B>::try_pop(valueDataType& value)
+{
+    size_t index = 0;
+
+    while (arrivals.try_pop(index))
+    {
+        slotType& slot = slots.begin()[index];
+
+        //cleared before the value is read so an update from here on queues the key again instead of being lost
+        slot.dirty.exchange(false, std::memory_order_acq_rel);
+
+        uint64_t sequence;
+
+        do
+        {
+            //an odd sequence means the producer is in the middle of writing the value
+            while ((sequence = slot.sequence.load(std::memory_order_acquire)) & 1) continue;
+
+            value = slot.value;
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        while (slot.sequence.load(std::memory_order_relaxed) != sequence);
+
+        //the update that queued the key again was already handed out by the previous pop
+        if (sequence == slot.delivered_sequence)
+        {
+            skipped.add(1);
+
+            continue;
+        }
+
+        slot.delivered_sequence = sequence;
+        last_slot = &slot;
+
+        popped.add(1);
+
+        return true;
+    }
+
+    return false;
+}
+
+#endif
@@ -0,0 +1,130 @@
+
+//record a live stream to a capture file, then map the file and walk the recorded messages
+
+#include "exceptUtils.h" //needed for custom exception class
+#include "socketUtils.h" //needed for the wsa and ssl context wrappers
+#include "httpUtils.h" //needed for the http response object
+#include "wsUtils.h"
+#include "captureUtils.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <string>
+
+//receive a number of messages with every one of them recorded to the capture file
+void record(SSLContextWrapper& ssl_context_wrapper, const std::string& path, const int message_count)
+{
+    //the writer is declared first so it outlives the websocket that records into it
+    captureWriter writer(path);
+
+    //blocking websocket with a 10 second timeout that does not signal on ping frames
+    websocket websocket_client(ssl_context_wrapper, "streamer.finance.yahoo.com", true, false, 10);
+
+    //kernel receive timestamps are recorded when they are enabled - otherwise the realtime clock when recv delivered the message
+    websocket_client.setRecvTimestamps(true);
+    websocket_client.setCapture(&writer);
+
+    websocket_client.reInit();
+
+    dictionary headers;
+
+    headers["Upgrade"] = "websocket";
+    headers["Connection"] = "Upgrade";
+    headers["Sec-WebSocket-Version"] = "13";
+    headers["Sec-Websocket-Key"] = generateRandomBase64String(16);
+
+    http::httpResponse response;
+
+    websocket_client.open(headers, "/", response);
+
+    if (response.status_code != 101) throw exceptions::exception("Could not open the websocket connection.");
+
+    websocket_client.send("{\"subscribe\": [\"BTC-USD\", \"ETH-USD\", \"SOL-USD\", \"DOGE-USD\"]}", WS_TEXT_FRAME);
+
+    std::string_view message;
+
+    for (int received = 0; received < message_count;)
+    {
+        if (websocket_client.recv(message)) ++received;
+    }
+
+    websocket_client.setCapture(nullptr);
+    writer.close();
+
+    std::cout << "recorded : " << writer.records() << " messages - dropped : " << writer.dropped() << " - file size : " << writer.bytes_written() << " bytes" << std::endl;
+}
+
+//iterate the capture without copying - payloads point into the mapped file
+void replay(const std::string& path)
+{
+    captureReader reader(path);
+    captureRecord record;
+
+    size_t messages = 0;
+    size_t payload_bytes = 0;
+
+    int64_t first_ns = 0;
+    int64_t last_ns = 0;
+
+    while (reader.next(record))
+    {
+        if (!messages) first_ns = record.timestamp_ns;
+
+        last_ns = record.timestamp_ns;
+        payload_bytes += record.payload.size();
+
+        ++messages;
+    }
+
+    std::cout << "read : " << messages << " messages with " << payload_bytes << " payload bytes spanning " << (last_ns - first_ns) / 1e6 << " ms" << std::endl;
+
+    //the same file can be served to a client by replayServer::loadCapture (replayUtils.h)
+}
+
+int main()
+{
+    try
+    {
+#ifdef _WIN32
+
+        WSAWrapper wsa_wrapper; //needed on Windows only - destructor must be called after all sockets are closed
+
+#endif
+
+        SSLContextWrapper ssl_context_wrapper; //destructor must be called after all sockets are closed
+
+        try
+        {
+            const std::string path = "yahoo_feed.wscap";
+
+            record(ssl_context_wrapper, path, 200);
+            replay(path);
+        }
+        catch (const exceptions::exception& exception)
+        {
+            std::cout << "Exception caught : " << exception.what() << std::endl;
+        }
+        catch (const std::runtime_error& runtime_error)
+        {
+            std::cout << "Runtime Error caught : " << runtime_error.what() << std::endl;
+        }
+        catch (const std::exception& exception)
+        {
+            std::cout << "Base Exception caught : " << exception.what() << std::endl;
+        }
+    }
+    catch (const exceptions::exception& exception)
+    {
+        std::cout << " - Exception caught : " << exception.what() << std::endl;
+    }
+    catch (const std::runtime_error& runtime_error)
+    {
+        std::cout << " - Runtime Error caught : " << runtime_error.what() << std::endl;
+    }
+    catch (const std::exception& exception)
+    {
+        std::cout << " - Base Exception caught : " << exception.what() << std::endl;
+    }
+
+    return 0;
+}
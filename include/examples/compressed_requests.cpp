@@ -0,0 +1,104 @@
+//fetch a large json page with and without gzip/deflate content encoding and compare the bytes read and the time taken
+
+#include "exceptUtils.h" //needed for custom exception class
+#include "socketUtils.h" //needed for the wsa and ssl context wrappers
+#include "httpUtils.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <string>
+#include <chrono>
+
+
+int main()
+{
+    try
+    {
+#ifdef _WIN32
+
+        WSAWrapper wsa_wrapper; //needed on Windows only - destructor must be called after all sockets are closed
+
+#endif
+
+        SSLContextWrapper ssl_context_wrapper; //destructor must be called after all sockets are closed
+
+        //placing the http client in an if or try/catch statement ensures that it will always be destroyed before ssl_context
+        //ALL SOCKET OBJECTS MUST BE DESTROYED BEFORE THE SSL_CONTEXT
+        try
+        {
+            //timeout in seconds
+            int timeout = 10;
+
+            //socket is blocking if true
+            bool blocking = false;
+
+            //specify the hostname - full urls are https://jsonplaceholder.typicode.com/photos etc.
+            std::string host = "jsonplaceholder.typicode.com";
+
+            //a large json page - standing in for a page of historical bars
+            std::string path = "/photos";
+
+            //requests per setting
+            int rounds = 5;
+
+            http::httpClient client(ssl_context_wrapper, host, blocking, timeout);
+
+            //initialize the http client - connect to the host
+            client.reConnect();
+
+            dictionary parameters;
+            dictionary headers;
+
+            headers["Connection"] = "keep-alive";
+
+            http::httpResponse response;
+
+            for (bool compression : { false, true })
+            {
+                client.setCompression(compression);
+
+                uint64_t bytes_before = client.get_stats().bytes_read.get();
+
+                auto start = std::chrono::steady_clock::now();
+
+                for (int i = 0; i < rounds; ++i) client.get(response, parameters, headers, path);
+
+                double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                //the bytes read include the response headers
+                uint64_t bytes_read = client.get_stats().bytes_read.get() - bytes_before;
+
+                std::cout << (compression ? "gzip/deflate" : "uncompressed") << " : " << response.status_code << " - " << response.message.size() << " byte body" << std::endl;
+                std::cout << "    Content-Encoding : " << (response.encoded ? response.find("Content-Encoding") : "none") << std::endl;
+                std::cout << "    bytes read per response : " << bytes_read / rounds << std::endl;
+                std::cout << "    total time per response : " << total_ms / rounds << " ms" << std::endl;
+            }
+        }
+        catch (const exceptions::exception& exception)
+        {
+            std::cout << "Exception caught : " << exception.what() << std::endl;
+        }
+        catch (const std::runtime_error& runtime_error)
+        {
+            std::cout << "Runtime Error caught : " << runtime_error.what() << std::endl;
+        }
+        catch (const std::exception& exception)
+        {
+            std::cout << "Base Exception caught : " << exception.what() << std::endl;
+        }
+    }
+    catch (const exceptions::exception& exception)
+    {
+        std::cout << " - Exception caught : " << exception.what() << std::endl;
+    }
+    catch (const std::runtime_error& runtime_error)
+    {
+        std::cout << " - Runtime Error caught : " << runtime_error.what() << std::endl;
+    }
+    catch (const std::exception& exception)
+    {
+        std::cout << " - Base Exception caught : " << exception.what() << std::endl;
+    }
+
+    return 0;
+}
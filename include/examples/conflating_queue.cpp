@@ -0,0 +1,67 @@
+
+//a producer publishes a burst of quotes faster than a slow consumer can handle them - the consumer only ever sees the latest quote per symbol
+
+#include "conflateUtils.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+//values are copied under a seqlock so they must be trivially copyable
+struct quote
+{
+    double bid;
+    double ask;
+
+    int64_t time; //nanoseconds
+};
+
+int main()
+{
+    std::vector<std::string> symbols = { "AAPL", "MSFT", "NVDA", "AMZN", "GOOGL", "META", "TSLA", "SPY", "QQQ", "IWM" };
+
+    //up to 16 symbols in 32 hash bins - large enough instances should live on the heap
+    auto quotes = std::make_unique<conflatingQueue<std::string, quote, 16, 32>>();
+
+    quotes->initializeKeys(symbols);
+
+    std::atomic<bool> finished = false;
+
+    //the open - a million quotes as fast as the producer can publish them
+    std::thread producer([&]()
+    {
+        for (int index = 0; index < 1000000; ++index)
+        {
+            const std::string& symbol = symbols[(index * 7) % symbols.size()];
+
+            quotes->update(symbol, quote{ 100.0 + index % 100, 100.01 + index % 100, index });
+        }
+
+        finished.store(true, std::memory_order_release);
+    });
+
+    quote latest{};
+
+    //a strategy that takes 10 microseconds per quote
+    while (!finished.load(std::memory_order_acquire) || quotes->pending())
+    {
+        if (!quotes->try_pop(latest)) continue;
+
+        auto busy_until = std::chrono::steady_clock::now() + std::chrono::microseconds(10);
+
+        while (std::chrono::steady_clock::now() < busy_until) continue;
+    }
+
+    producer.join();
+
+    std::cout << "updates published : " << quotes->updates() << std::endl;
+    std::cout << "quotes processed : " << quotes->delivered() << std::endl;
+    std::cout << "updates conflated : " << quotes->conflated() << std::endl;
+    std::cout << "last quote : " << quotes->last_key() << " " << latest.bid << " x " << latest.ask << std::endl;
+
+    return 0;
+}
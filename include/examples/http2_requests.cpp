@@ -0,0 +1,123 @@
+//many requests over one http/2 connection - one stream at a time and then all streams concurrently
+
+#include "exceptUtils.h" //needed for custom exception class
+#include "socketUtils.h" //needed for the wsa and ssl context wrappers
+#include "http2Utils.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+
+int main()
+{
+    try
+    {
+#ifdef _WIN32
+
+        WSAWrapper wsa_wrapper; //needed on Windows only - destructor must be called after all sockets are closed
+
+#endif
+
+        SSLContextWrapper ssl_context_wrapper; //destructor must be called after all sockets are closed
+
+        //placing the http client in an if or try/catch statement ensures that it will always be destroyed before ssl_context
+        //ALL SOCKET OBJECTS MUST BE DESTROYED BEFORE THE SSL_CONTEXT
+        try
+        {
+            //timeout in seconds
+            int timeout = 10;
+
+            //socket is blocking if true
+            bool blocking = false;
+
+            //the host has to support http/2 - it is negotiated with ALPN during the tls handshake
+            std::string host = "www.google.com";
+
+            //the requests to have in flight at once - more than the server allows are queued until streams finish
+            std::vector<std::string> paths = { "/", "/robots.txt", "/humans.txt", "/favicon.ico", "/", "/robots.txt", "/humans.txt", "/favicon.ico" };
+
+            http::http2Client client(ssl_context_wrapper, host, "443", socketTransport::TLS, blocking, timeout);
+
+            //initialize the http2 client - connect to the host and exchange settings
+            client.reConnect();
+
+            dictionary parameters;
+            dictionary headers;
+
+            headers["Accept"] = "*/*";
+
+            std::vector<http::httpResponse> responses(paths.size());
+
+            //one stream at a time
+            auto start = std::chrono::steady_clock::now();
+
+            for (size_t i = 0; i < paths.size(); ++i) client.get(responses[i], parameters, headers, paths[i]);
+
+            double sequential_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            //every stream opened at once and the responses collected as they complete
+            start = std::chrono::steady_clock::now();
+
+            std::vector<uint32_t> stream_ids;
+
+            for (const std::string& path : paths) stream_ids.push_back(client.get(parameters, headers, path));
+
+            std::cout << client.open_streams() << " streams open, " << client.queued_streams() << " queued, server limit " << client.max_streams() << std::endl;
+
+            std::vector<bool> received(paths.size(), false);
+            size_t remaining = paths.size();
+
+            while (remaining)
+            {
+                for (size_t i = 0; i < stream_ids.size(); ++i)
+                {
+                    if (received[i]) continue;
+
+                    http::status current_status = client.recvResponse(stream_ids[i], responses[i]);
+
+                    if (current_status == http::status::RECEIVED_RESPONSE || current_status == http::status::TIMED_OUT)
+                    {
+                        received[i] = true;
+                        --remaining;
+                    }
+                }
+            }
+
+            double concurrent_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            for (size_t i = 0; i < paths.size(); ++i) std::cout << paths[i] << " : " << responses[i].status_code << " - " << responses[i].message.size() << " bytes" << std::endl;
+
+            std::cout << "\none stream at a time : " << sequential_ms << " ms" << std::endl;
+            std::cout << "concurrent streams : " << concurrent_ms << " ms" << std::endl;
+        }
+        catch (const exceptions::exception& exception)
+        {
+            std::cout << "Exception caught : " << exception.what() << std::endl;
+        }
+        catch (const std::runtime_error& runtime_error)
+        {
+            std::cout << "Runtime Error caught : " << runtime_error.what() << std::endl;
+        }
+        catch (const std::exception& exception)
+        {
+            std::cout << "Base Exception caught : " << exception.what() << std::endl;
+        }
+    }
+    catch (const exceptions::exception& exception)
+    {
+        std::cout << " - Exception caught : " << exception.what() << std::endl;
+    }
+    catch (const std::runtime_error& runtime_error)
+    {
+        std::cout << " - Runtime Error caught : " << runtime_error.what() << std::endl;
+    }
+    catch (const std::exception& exception)
+    {
+        std::cout << " - Base Exception caught : " << exception.what() << std::endl;
+    }
+
+    return 0;
+}
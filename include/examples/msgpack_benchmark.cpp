@@ -0,0 +1,172 @@
+
+//compare the per message cost of decoding the same trade events from json and from messagepack
+
+#include "jsonUtils.h"
+#include "mpUtils.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+//a trade event from the alpaca data stream - {"T":"t","S":"AAPL","i":52983525029461,"x":"V","p":187.25,"s":100,"t":"2021-02-22T15:51:44.208Z","z":"C"}
+struct trade
+{
+    std::string symbol; //S
+    std::string time; //t - json sends rfc 3339 text
+
+    int64_t time_ns = 0; //t - messagepack sends a timestamp extension
+    int64_t id = 0; //i
+    int64_t size = 0; //s
+
+    double price = 0; //p
+
+    char exchange = 0; //x
+    char tape = 0; //z
+};
+
+//something to do with each trade so the compiler cannot skip the parsing
+struct tradeTotals
+{
+    uint64_t count = 0;
+
+    double notional = 0;
+};
+
+void jsonTradeUpdate(trade& container_object, const std::string& key, const std::string& value)
+{
+    if (key == "S") container_object.symbol = value;
+    else if (key == "t") container_object.time = value;
+    else if (key == "i") container_object.id = std::stoll(value);
+    else if (key == "s") container_object.size = std::stoll(value);
+    else if (key == "p") container_object.price = std::stod(value);
+    else if (key == "x") container_object.exchange = value.empty() ? 0 : value[0];
+    else if (key == "z") container_object.tape = value.empty() ? 0 : value[0];
+}
+
+void msgpackTradeUpdate(trade& container_object, const std::string_view key, const msgpackValue& value)
+{
+    if (key.size() != 1) return;
+
+    switch (key[0])
+    {
+    case 'S': container_object.symbol.assign(value.bytes.data(), value.bytes.size()); break; //reuses the capacity of the string
+    case 't': container_object.time_ns = value.as_int(); break;
+    case 'i': container_object.id = value.as_int(); break;
+    case 's': container_object.size = value.as_int(); break;
+    case 'p': container_object.price = value.as_double(); break;
+    case 'x': container_object.exchange = value.bytes.empty() ? 0 : value.bytes[0]; break;
+    case 'z': container_object.tape = value.bytes.empty() ? 0 : value.bytes[0]; break;
+    default: break;
+    }
+}
+
+void totalsUpdate(const trade& container_object, tradeTotals& totals)
+{
+    totals.count++;
+    totals.notional += container_object.price * container_object.size;
+}
+
+//minimal messagepack encoding helpers to build the test message
+void packHeader(std::string& out, const unsigned char format, const uint64_t value, const int bytes)
+{
+    out += static_cast<char>(format);
+
+    for (int index = bytes - 1; index >= 0; --index) out += static_cast<char>(value >> (8 * index));
+}
+
+void packString(std::string& out, const std::string& text)
+{
+    if (text.size() < 32) out += static_cast<char>(0xa0 | text.size());
+    else packHeader(out, 0xd9, text.size(), 1);
+
+    out += text;
+}
+
+void packUnsigned(std::string& out, const uint64_t value)
+{
+    if (value < 128) out += static_cast<char>(value);
+    else packHeader(out, 0xcf, value, 8);
+}
+
+void packDouble(std::string& out, const double value)
+{
+    uint64_t bits;
+
+    memcpy(&bits, &value, 8);
+    packHeader(out, 0xcb, bits, 8);
+}
+
+void packTimestamp(std::string& out, const uint64_t seconds, const uint64_t nanoseconds)
+{
+    out += static_cast<char>(0xd7); //fixext 8
+    out += static_cast<char>(0xff); //type -1
+
+    uint64_t bits = nanoseconds << 34 | seconds;
+
+    for (int index = 7; index >= 0; --index) out += static_cast<char>(bits >> (8 * index));
+}
+
+int main()
+{
+    const int events_per_message = 10;
+    const int iterations = 100000;
+
+    std::string json_message = "[";
+    std::string msgpack_message;
+
+    packHeader(msgpack_message, 0xdc, events_per_message, 2); //array 16
+
+    for (int index = 0; index < events_per_message; ++index)
+    {
+        std::string id = std::to_string(52983525029461LL + index);
+        std::string price = std::to_string(187.25 + index * 0.01);
+
+        json_message += std::string(index ? "," : "") + "{\"T\":\"t\",\"S\":\"AAPL\",\"i\":" + id + ",\"x\":\"V\",\"p\":" + price +
+            ",\"s\":" + std::to_string(100 + index) + ",\"t\":\"2021-02-22T15:51:44.208Z\",\"z\":\"C\"}";
+
+        msgpack_message += static_cast<char>(0x88); //fixmap with 8 pairs
+
+        packString(msgpack_message, "T"); packString(msgpack_message, "t");
+        packString(msgpack_message, "S"); packString(msgpack_message, "AAPL");
+        packString(msgpack_message, "i"); packUnsigned(msgpack_message, 52983525029461ULL + index);
+        packString(msgpack_message, "x"); packString(msgpack_message, "V");
+        packString(msgpack_message, "p"); packDouble(msgpack_message, 187.25 + index * 0.01);
+        packString(msgpack_message, "s"); packUnsigned(msgpack_message, 100 + index);
+        packString(msgpack_message, "t"); packTimestamp(msgpack_message, 1614009104, 208000000);
+        packString(msgpack_message, "z"); packString(msgpack_message, "C");
+    }
+
+    json_message += "]";
+
+    std::cout << "json message : " << json_message.size() << " bytes - messagepack message : " << msgpack_message.size() << " bytes" << std::endl;
+
+    JSONArrayParser<trade, tradeTotals, jsonTradeUpdate, totalsUpdate> json_parser;
+    MsgPackArrayParser<trade, tradeTotals, msgpackTradeUpdate, totalsUpdate> msgpack_parser;
+
+    tradeTotals json_totals;
+    tradeTotals msgpack_totals;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int iteration = 0; iteration < iterations; ++iteration) json_parser.parseJSONArray(json_message, json_totals);
+
+    auto json_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+
+    for (int iteration = 0; iteration < iterations; ++iteration) msgpack_parser.parseMsgPackArray(msgpack_message, msgpack_totals);
+
+    auto msgpack_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "json : " << static_cast<double>(json_ns) / json_totals.count << " ns per event (" << json_totals.count << " events, notional " << json_totals.notional << ")" << std::endl;
+    std::cout << "messagepack : " << static_cast<double>(msgpack_ns) / msgpack_totals.count << " ns per event (" << msgpack_totals.count << " events, notional " << msgpack_totals.notional << ")" << std::endl;
+
+    const trade& last_trade = msgpack_parser.get_info();
+
+    std::cout << "last trade : " << last_trade.symbol << " " << last_trade.size << " @ " << last_trade.price << " - exchange " << last_trade.exchange << " - time " << last_trade.time_ns << " ns" << std::endl;
+
+    return 0;
+}
@@ -5,6 +5,7 @@
 #include "socketUtils.h" //needed for the wsa and ssl context wrappers
 #include "httpUtils.h" //needed for the http response object
 #include "wsUtils.h"
+#include "pbUtils.h" //needed to decode the protobuf messages
 
 #include <stdexcept>
 #include <iostream>
@@ -88,16 +89,33 @@ int main()
             std::string last_message1;
             std::string last_message2;
 
+            //decode the messages from each websocket
+            yahooPricingData pricing_data1;
+            yahooPricingData pricing_data2;
+
+            pricing_data1.clear();
+            pricing_data2.clear();
+
             //print incoming messages from both websockets
             while (true)
             {
                 //non-blocking sockets will return if no message is pending and will not block execution
 
                 //check for a pending message from the first websocket
-                if (websocket_client1.recv(last_message1)) std::cout << "FROM WEBSOCKET 1 : " << last_message1 << "\n\n";
+                if (websocket_client1.recv(last_message1))
+                {
+                    parseYahooPricingData(last_message1, pricing_data1);
+
+                    std::cout << "FROM WEBSOCKET 1 : " << pricing_data1.get_symbol() << " " << pricing_data1.price << "\n\n";
+                }
 
                 //check for a pending message from the second websocket
-                if (websocket_client2.recv(last_message2)) std::cout << "FROM WEBSOCKET 2 : " << last_message2 << "\n\n";
+                if (websocket_client2.recv(last_message2))
+                {
+                    parseYahooPricingData(last_message2, pricing_data2);
+
+                    std::cout << "FROM WEBSOCKET 2 : " << pricing_data2.get_symbol() << " " << pricing_data2.price << "\n\n";
+                }
             }
         }
         catch (const exceptions::exception& exception)
@@ -0,0 +1,102 @@
+//poll several endpoints over one keep-alive connection - one request at a time and then pipelined
+
+#include "exceptUtils.h" //needed for custom exception class
+#include "socketUtils.h" //needed for the wsa and ssl context wrappers
+#include "httpUtils.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+
+int main()
+{
+    try
+    {
+#ifdef _WIN32
+
+        WSAWrapper wsa_wrapper; //needed on Windows only - destructor must be called after all sockets are closed
+
+#endif
+
+        SSLContextWrapper ssl_context_wrapper; //destructor must be called after all sockets are closed
+
+        //placing the http client in an if or try/catch statement ensures that it will always be destroyed before ssl_context
+        //ALL SOCKET OBJECTS MUST BE DESTROYED BEFORE THE SSL_CONTEXT
+        try
+        {
+            //timeout in seconds
+            int timeout = 10;
+
+            //socket is blocking if true
+            bool blocking = false;
+
+            //specify the hostname - full urls are https://jsonplaceholder.typicode.com/users/1 etc.
+            std::string host = "jsonplaceholder.typicode.com";
+
+            //the periodic polling sequence - standing in for account, positions, and orders
+            std::vector<std::string> paths = { "/users/1", "/posts?userId=1", "/todos?userId=1" };
+
+            http::httpClient client(ssl_context_wrapper, host, blocking, timeout);
+
+            //initialize the http client - connect to the host
+            client.reConnect();
+
+            dictionary parameters;
+            dictionary headers;
+
+            headers["Connection"] = "keep-alive"; //the connection has to stay open for the next requests
+
+            std::vector<http::httpResponse> responses(paths.size());
+
+            //one round trip per request
+            auto start = std::chrono::steady_clock::now();
+
+            for (size_t i = 0; i < paths.size(); ++i) client.get(responses[i], parameters, headers, paths[i]);
+
+            double sequential_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            //every request written back to back and the responses read in order - about one round trip in total
+            start = std::chrono::steady_clock::now();
+
+            for (const std::string& path : paths) client.pipeline(parameters, headers, path);
+
+            client.recvPipeline(responses);
+
+            double pipelined_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            for (size_t i = 0; i < paths.size(); ++i) std::cout << paths[i] << " : " << responses[i].status_code << " - " << responses[i].message.size() << " bytes" << std::endl;
+
+            std::cout << "\none at a time : " << sequential_ms << " ms" << std::endl;
+            std::cout << "pipelined : " << pipelined_ms << " ms" << std::endl;
+        }
+        catch (const exceptions::exception& exception)
+        {
+            std::cout << "Exception caught : " << exception.what() << std::endl;
+        }
+        catch (const std::runtime_error& runtime_error)
+        {
+            std::cout << "Runtime Error caught : " << runtime_error.what() << std::endl;
+        }
+        catch (const std::exception& exception)
+        {
+            std::cout << "Base Exception caught : " << exception.what() << std::endl;
+        }
+    }
+    catch (const exceptions::exception& exception)
+    {
+        std::cout << " - Exception caught : " << exception.what() << std::endl;
+    }
+    catch (const std::runtime_error& runtime_error)
+    {
+        std::cout << " - Runtime Error caught : " << runtime_error.what() << std::endl;
+    }
+    catch (const std::exception& exception)
+    {
+        std::cout << " - Base Exception caught : " << exception.what() << std::endl;
+    }
+
+    return 0;
+}
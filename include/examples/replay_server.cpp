@@ -0,0 +1,114 @@
+
+//replay recorded messages from a local server as fast as a websocket client can read them and compare the two ends' rates
+
+#include "exceptUtils.h" //needed for custom exception class
+#include "socketUtils.h" //needed for the wsa and ssl context wrappers
+#include "httpUtils.h" //needed for the http response object
+#include "wsUtils.h"
+#include "replayUtils.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <string>
+#include <chrono>
+
+int main()
+{
+    try
+    {
+#ifdef _WIN32
+
+        WSAWrapper wsa_wrapper; //needed on Windows only - destructor must be called after all sockets are closed
+
+#endif
+
+        SSLContextWrapper ssl_context_wrapper; //destructor must be called after all sockets are closed
+
+        try
+        {
+            const int message_count = 100000;
+
+            replayOptions options;
+
+            options.speed = 0; //no pacing - send as fast as the client reads
+            options.batch = 32; //several frames per send so the client's reads hold more than one frame
+
+            replayServer server(9001, options);
+
+            //a recording could be loaded with server.loadCapture("feed.wscap") or server.loadLines("trades.jsonl", 1000) instead
+            for (int index = 0; index < message_count; ++index)
+            {
+                server.add(index * 1000ll, "{\"T\":\"t\",\"S\":\"BTC-USD\",\"i\":" + std::to_string(index) + ",\"p\":67012.5,\"s\":0.0125,\"t\":\"2024-05-01T12:00:00.123456Z\"}");
+            }
+
+            server.start();
+
+            //the websocket lives in this scope so it is closed before the server stops
+            {
+                //blocking websocket over plain tcp with a 10 second timeout that does not signal on ping frames
+                websocket websocket_client(ssl_context_wrapper, "127.0.0.1", "9001", socketTransport::TCP, true, false, 10);
+
+                websocket_client.reInit();
+
+                dictionary headers;
+
+                headers["Upgrade"] = "websocket";
+                headers["Connection"] = "Upgrade";
+                headers["Sec-WebSocket-Version"] = "13";
+                headers["Sec-Websocket-Key"] = generateRandomBase64String(16);
+
+                http::httpResponse response;
+
+                websocket_client.open(headers, "/", response);
+
+                if (response.status_code != 101) throw exceptions::exception("Could not open the websocket connection.");
+
+                std::string_view message;
+
+                auto start = std::chrono::steady_clock::now();
+
+                for (int received = 0; received < message_count;)
+                {
+                    if (websocket_client.recv(message)) ++received;
+                }
+
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                std::cout << "client received : " << message_count << " messages in " << seconds * 1e3 << " ms" << std::endl;
+                std::cout << "client rate : " << message_count / seconds << " messages per second" << std::endl;
+                std::cout << "last message : " << message << std::endl;
+            }
+
+            server.stop();
+
+            std::cout << "server delivered : " << server.delivered() << " messages (" << server.delivered_bytes() << " payload bytes) to " << server.sessions() << " session(s)" << std::endl;
+            std::cout << "server rate : " << server.last_session_rate() << " messages per second" << std::endl;
+        }
+        catch (const exceptions::exception& exception)
+        {
+            std::cout << "Exception caught : " << exception.what() << std::endl;
+        }
+        catch (const std::runtime_error& runtime_error)
+        {
+            std::cout << "Runtime Error caught : " << runtime_error.what() << std::endl;
+        }
+        catch (const std::exception& exception)
+        {
+            std::cout << "Base Exception caught : " << exception.what() << std::endl;
+        }
+    }
+    catch (const exceptions::exception& exception)
+    {
+        std::cout << " - Exception caught : " << exception.what() << std::endl;
+    }
+    catch (const std::runtime_error& runtime_error)
+    {
+        std::cout << " - Runtime Error caught : " << runtime_error.what() << std::endl;
+    }
+    catch (const std::exception& exception)
+    {
+        std::cout << " - Base Exception caught : " << exception.what() << std::endl;
+    }
+
+    return 0;
+}
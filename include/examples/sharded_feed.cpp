@@ -0,0 +1,136 @@
+
+//spread crypto symbols across several yahoo finance connections, each decoded on its own pinned thread, and read them as one feed
+
+#include "exceptUtils.h" //needed for custom exception class
+#include "socketUtils.h" //needed for the wsa and ssl context wrappers
+#include "httpUtils.h" //needed for the dictionary type
+#include "wsUtils.h"
+#include "pbUtils.h" //needed to decode the protobuf messages
+#include "shardUtils.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+//builds {"subscribe": ["BTC-USD", "ETH-USD"]} and the matching unsubscribe message
+std::string formatSymbols(const char* action, const std::vector<std::string>& symbols)
+{
+    std::string message = std::string("{\"") + action + "\": [";
+
+    for (size_t index = 0; index < symbols.size(); ++index)
+    {
+        if (index) message += ", ";
+
+        message += "\"" + symbols[index] + "\"";
+    }
+
+    return message + "]}";
+}
+
+//runs on the shard's receive thread
+bool parsePricing(const websocket&, const std::string_view payload, yahooPricingData& pricing_data)
+{
+    try
+    {
+        //the view points into the websocket's receive buffer, which is not read again, so the message can be decoded in place
+        parseYahooPricingData(const_cast<char*>(payload.data()), payload.size(), pricing_data);
+    }
+    catch (const std::runtime_error&) { return false; } //skip anything that is not a pricing message
+
+    return true;
+}
+
+int main()
+{
+    try
+    {
+#ifdef _WIN32
+
+        WSAWrapper wsa_wrapper; //needed on Windows only - destructor must be called after all sockets are closed
+
+#endif
+
+        SSLContextWrapper ssl_context_wrapper; //destructor must be called after all sockets are closed
+
+        //the feed lives inside the try block so its websockets are always destroyed before ssl_context
+        try
+        {
+            dictionary headers;
+
+            headers["Upgrade"] = "websocket";
+            headers["Connection"] = "Upgrade";
+            headers["Sec-WebSocket-Version"] = "13";
+
+            std::vector<std::string> universe = { "BTC-USD", "ETH-USD", "SOL-USD", "DOGE-USD", "XRP-USD", "ADA-USD", "AVAX-USD", "LINK-USD" };
+
+            //two shards with their receive threads pinned to cores 1 and 2 - the consumer runs on this thread
+            shardedFeed<yahooPricingData, 4096> feed(ssl_context_wrapper, "streamer.finance.yahoo.com", "443", socketTransport::TLS, headers, "/", 10, { 1, 2 },
+                [](const std::vector<std::string>& symbols) { return formatSymbols("subscribe", symbols); },
+                [](const std::vector<std::string>& symbols) { return formatSymbols("unsubscribe", symbols); },
+                parsePricing,
+                [](const yahooPricingData& pricing_data) { return pricing_data.get_symbol(); });
+
+            feed.start(universe);
+
+            auto next_rebalance = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+            for (int received = 0; received < 500;)
+            {
+                yahooPricingData* pricing_data = feed.front();
+
+                if (!pricing_data)
+                {
+                    for (size_t shard = 0; shard < feed.shard_count(); ++shard) if (feed.failed(shard)) feed.restart(shard);
+
+                    continue;
+                }
+
+                std::cout << pricing_data->get_symbol() << " " << pricing_data->price << "\n";
+
+                feed.pop();
+
+                ++received;
+
+                //move hot symbols off the busiest connection every 10 seconds
+                if (std::chrono::steady_clock::now() >= next_rebalance)
+                {
+                    for (size_t shard = 0; shard < feed.shard_count(); ++shard) std::cout << "shard " << shard << " load : " << feed.load(shard) << "\n";
+
+                    std::cout << "symbols moved : " << feed.rebalance() << "\n";
+
+                    next_rebalance += std::chrono::seconds(10);
+                }
+            }
+
+            feed.stop();
+        }
+        catch (const exceptions::exception& exception)
+        {
+            std::cout << "Exception caught : " << exception.what() << std::endl;
+        }
+        catch (const std::runtime_error& runtime_error)
+        {
+            std::cout << "Runtime Error caught : " << runtime_error.what() << std::endl;
+        }
+        catch (const std::exception& exception)
+        {
+            std::cout << "Base Exception caught : " << exception.what() << std::endl;
+        }
+    }
+    catch (const exceptions::exception& exception)
+    {
+        std::cout << " - Exception caught : " << exception.what() << std::endl;
+    }
+    catch (const std::runtime_error& runtime_error)
+    {
+        std::cout << " - Runtime Error caught : " << runtime_error.what() << std::endl;
+    }
+    catch (const std::exception& exception)
+    {
+        std::cout << " - Base Exception caught : " << exception.what() << std::endl;
+    }
+
+    return 0;
+}
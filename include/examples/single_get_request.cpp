@@ -66,7 +66,7 @@ int main()
             if (response.status_code != 200) throw exceptions::exception("Http get request failed.");
 
             //print the fields from the response header
-            for (const auto& pair : response.fields) std::cout << pair.first << " : " << pair.second << std::endl;
+            for (size_t index = 0; index < response.fields.size(); ++index) std::cout << response.field_name(index) << " : " << response.field_value(index) << std::endl;
 
             //print the response body
             std::cout << '\n' << response.message << std::endl;
@@ -4,6 +4,7 @@
 #include "socketUtils.h" //needed for the wsa and ssl context wrappers
 #include "httpUtils.h" //needed for the http response object
 #include "wsUtils.h"
+#include "pbUtils.h" //needed to decode the protobuf messages
 
 #include <stdexcept>
 #include <iostream>
@@ -62,7 +63,7 @@ int main()
             websocket_client.open(headers, path.c_str(), response);
 
             //status code should be 101 in most cases
-            std::cout << "Received status code : " << response.status_code << " - with the following message : " << response.status_message << std::endl;
+            std::cout << "Received status code : " << response.status_code << " - with the following message : " << response.status_message() << std::endl;
 
             //if we dont get 101 then something went wrong
             if (response.status_code != 101) throw exceptions::exception("Could not open the websocket connection.");
@@ -73,10 +74,21 @@ int main()
             //write individual messages to last_message
             std::string last_message;
 
+            //decode messages into pricing_data - fields missing from an update keep their previous values
+            yahooPricingData pricing_data;
+
+            pricing_data.clear();
+
             //print incoming messages from the websocket
             while (true)
             {
-                if (websocket_client.recv(last_message)) std::cout << last_message << std::endl;
+                if (websocket_client.recv(last_message))
+                {
+                    //the messages are base64 encoded protobuf messages - decode them in place
+                    parseYahooPricingData(last_message, pricing_data);
+
+                    std::cout << pricing_data.get_symbol() << " : price " << pricing_data.price << " - change " << pricing_data.change << " - day volume " << pricing_data.day_volume << " - time " << pricing_data.time << std::endl;
+                }
             }
         }
         catch (const exceptions::exception& exception)
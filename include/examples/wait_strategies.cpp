@@ -0,0 +1,139 @@
+
+//read the same paced replay with each wait strategy and compare how late messages are picked up against the cpu time spent waiting for them
+
+#include "exceptUtils.h" //needed for custom exception class
+#include "socketUtils.h" //needed for the wsa and ssl context wrappers
+#include "httpUtils.h" //needed for the http response object
+#include "wsUtils.h"
+#include "waitUtils.h"
+#include "replayUtils.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <string>
+#include <ctime>
+#include <algorithm>
+
+int main()
+{
+    try
+    {
+#ifdef _WIN32
+
+        WSAWrapper wsa_wrapper; //needed on Windows only - destructor must be called after all sockets are closed
+
+#endif
+
+        SSLContextWrapper ssl_context_wrapper; //destructor must be called after all sockets are closed
+
+        try
+        {
+            const int message_count = 1000;
+            const int64_t spacing_ns = 2000000; //one message every 2ms - long enough for the adaptive strategy to reach poll
+
+            replayOptions options;
+
+            options.speed = 1; //send at the recorded pace so the client waits between messages
+
+            replayServer server(9002, options);
+
+            for (int index = 0; index < message_count; ++index)
+            {
+                server.add(index * spacing_ns, "{\"T\":\"q\",\"S\":\"BTC-USD\",\"i\":" + std::to_string(index) + ",\"bp\":67012.5,\"ap\":67013.0}");
+            }
+
+            server.start();
+
+            const char* names[] = { "busy poll", "adaptive", "blocking" };
+            const waitStrategy strategies[] = { waitStrategy::busyPoll(), waitStrategy::adaptive(), waitStrategy::blocking(WAIT_UTILS_BLOCK_MS) };
+
+            for (int choice = 0; choice < 3; ++choice)
+            {
+                //non-blocking websocket over plain tcp with a 10 second timeout that does not signal on ping frames
+                websocket websocket_client(ssl_context_wrapper, "127.0.0.1", "9002", socketTransport::TCP, false, false, 10);
+
+                websocket_client.setWaitStrategy(strategies[choice]);
+                websocket_client.reInit();
+
+                dictionary headers;
+
+                headers["Upgrade"] = "websocket";
+                headers["Connection"] = "Upgrade";
+                headers["Sec-WebSocket-Version"] = "13";
+                headers["Sec-Websocket-Key"] = generateRandomBase64String(16);
+
+                http::httpResponse response;
+
+                websocket_client.open(headers, "/", response);
+
+                if (response.status_code != 101) throw exceptions::exception("Could not open the websocket connection.");
+
+                std::string_view message;
+
+                int64_t first_ns = 0;
+                int64_t total_late_ns = 0;
+                int64_t max_late_ns = 0;
+
+                std::clock_t cpu_start = std::clock();
+
+                for (int received = 0; received < message_count;)
+                {
+                    if (!websocket_client.recv(message))
+                    {
+                        websocket_client.idle(); //spin, pause, or poll until the next read
+
+                        continue;
+                    }
+
+                    //the first message sets the schedule - later ones are late by however long after their replay offset they were read
+                    int64_t now = steadyNanoseconds();
+
+                    if (!received) first_ns = now;
+
+                    int64_t late_ns = std::max<int64_t>(now - first_ns - received * spacing_ns, 0);
+
+                    total_late_ns += late_ns;
+                    max_late_ns = std::max(max_late_ns, late_ns);
+
+                    ++received;
+                }
+
+                //process cpu time - includes the replay server's thread, which is the same for every strategy
+                double cpu_ms = 1e3 * (std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+                const socketStats& stats = websocket_client.get_stats();
+
+                std::cout << names[choice] << " : cpu " << cpu_ms << " ms, mean lateness " << total_late_ns / message_count / 1000.0 << " us, max lateness " << max_late_ns / 1000.0 << " us" << std::endl;
+                std::cout << "    spins " << stats.idle_spins.get() << ", pauses " << stats.idle_pauses.get() << ", polls " << stats.idle_blocks.get() << std::endl;
+            }
+
+            server.stop();
+        }
+        catch (const exceptions::exception& exception)
+        {
+            std::cout << "Exception caught : " << exception.what() << std::endl;
+        }
+        catch (const std::runtime_error& runtime_error)
+        {
+            std::cout << "Runtime Error caught : " << runtime_error.what() << std::endl;
+        }
+        catch (const std::exception& exception)
+        {
+            std::cout << "Base Exception caught : " << exception.what() << std::endl;
+        }
+    }
+    catch (const exceptions::exception& exception)
+    {
+        std::cout << " - Exception caught : " << exception.what() << std::endl;
+    }
+    catch (const std::runtime_error& runtime_error)
+    {
+        std::cout << " - Runtime Error caught : " << runtime_error.what() << std::endl;
+    }
+    catch (const std::exception& exception)
+    {
+        std::cout << " - Base Exception caught : " << exception.what() << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+
+//compare bytes received and cpu time per message with permessage-deflate on and off
+
+#include "exceptUtils.h" //needed for custom exception class
+#include "socketUtils.h" //needed for the wsa and ssl context wrappers
+#include "httpUtils.h" //needed for the http response object
+#include "wsUtils.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <string>
+#include <ctime>
+
+//open a websocket with or without compression, receive a number of messages, and print what they cost
+void measure(SSLContextWrapper& ssl_context_wrapper, const bool deflate, const int message_count)
+{
+    //blocking websocket with a 10 second timeout that does not signal on ping frames
+    websocket websocket_client(ssl_context_wrapper, "streamer.finance.yahoo.com", true, false, 10);
+
+    //offer permessage-deflate in the upgrade request - the server decides whether to use it
+    websocket_client.setPerMessageDeflate(deflate);
+
+    websocket_client.reInit();
+
+    dictionary headers;
+
+    headers["Upgrade"] = "websocket";
+    headers["Connection"] = "Upgrade";
+    headers["Sec-WebSocket-Version"] = "13";
+    headers["Sec-Websocket-Key"] = generateRandomBase64String(16);
+
+    http::httpResponse response;
+
+    websocket_client.open(headers, "/", response);
+
+    if (response.status_code != 101) throw exceptions::exception("Could not open the websocket connection.");
+
+    //only count what is received after the upgrade
+    uint64_t bytes_before = websocket_client.get_stats().bytes_read.get();
+
+    websocket_client.send("{\"subscribe\": [\"BTC-USD\", \"ETH-USD\", \"SOL-USD\", \"DOGE-USD\"]}", WS_TEXT_FRAME);
+
+    std::string_view message;
+
+    //process cpu time - time spent blocked in recv waiting for the server is not counted
+    std::clock_t cpu_start = std::clock();
+
+    for (int received = 0; received < message_count;)
+    {
+        if (websocket_client.recv(message)) ++received;
+    }
+
+    double cpu_us = 1e6 * (std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+    uint64_t bytes_read = websocket_client.get_stats().bytes_read.get() - bytes_before;
+
+    std::cout << "permessage-deflate offered : " << deflate << " - negotiated : " << websocket_client.per_message_deflate << std::endl;
+    std::cout << "bytes received per message : " << static_cast<double>(bytes_read) / message_count << std::endl;
+    std::cout << "cpu microseconds per message : " << cpu_us / message_count << std::endl;
+
+    if (websocket_client.per_message_deflate)
+    {
+        std::cout << "compressed bytes in : " << websocket_client.inflater.total_in() << " - decompressed bytes out : " << websocket_client.inflater.total_out() << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
+int main()
+{
+    try
+    {
+#ifdef _WIN32
+
+        WSAWrapper wsa_wrapper; //needed on Windows only - destructor must be called after all sockets are closed
+
+#endif
+
+        SSLContextWrapper ssl_context_wrapper; //destructor must be called after all sockets are closed
+
+        //the websockets live inside measure so they are always destroyed before ssl_context
+        try
+        {
+            int message_count = 200;
+
+            measure(ssl_context_wrapper, false, message_count);
+            measure(ssl_context_wrapper, true, message_count);
+        }
+        catch (const exceptions::exception& exception)
+        {
+            std::cout << "Exception caught : " << exception.what() << std::endl;
+        }
+        catch (const std::runtime_error& runtime_error)
+        {
+            std::cout << "Runtime Error caught : " << runtime_error.what() << std::endl;
+        }
+        catch (const std::exception& exception)
+        {
+            std::cout << "Base Exception caught : " << exception.what() << std::endl;
+        }
+    }
+    catch (const exceptions::exception& exception)
+    {
+        std::cout << " - Exception caught : " << exception.what() << std::endl;
+    }
+    catch (const std::runtime_error& runtime_error)
+    {
+        std::cout << " - Runtime Error caught : " << runtime_error.what() << std::endl;
+    }
+    catch (const std::exception& exception)
+    {
+        std::cout << " - Base Exception caught : " << exception.what() << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,253 @@
+
+#include "feedUtils.h"
+
+#include <chrono>
+
+feedConnection::feedConnection(const feedConnection& other_feed) : ssl_context_wrapper(other_feed.ssl_context_wrapper)
+{
+	throw std::runtime_error("feedConnection type doesn't support copy construction.");
+}
+
+feedConnection::feedConnection(const SSLContextWrapper& SSL_context_wrapper, const std::string Host, const std::string Port, const socketTransport Transport,
+	const dictionary& Headers, const std::string Path, const bool Blocking, const time_t Timeout, const int64_t Min_backoff_ms, const int64_t Max_backoff_ms)
+	: ssl_context_wrapper(const_cast<SSLContextWrapper&>(SSL_context_wrapper)), host(Host), port(Port), path(Path), transport(Transport), headers(Headers),
+	blocking(Blocking), timeout(Timeout), min_backoff_ms(Min_backoff_ms), max_backoff_ms(Max_backoff_ms),
+	heartbeat_ping_ms(0), heartbeat_stale_ms(0), running(false), failovers(0)
+{
+	//every connection generates its own key
+	headers.erase("Sec-Websocket-Key");
+	headers.erase("Sec-WebSocket-Key");
+}
+
+feedConnection::~feedConnection()
+{
+	stop();
+}
+
+feedConnection& feedConnection::operator=(const feedConnection& other_feed)
+{
+	throw std::runtime_error("feedConnection type doesn't support item assignment.");
+}
+
+std::unique_ptr<websocket> feedConnection::connectSocket()
+{
+	std::unique_ptr<websocket> socket = std::make_unique<websocket>(ssl_context_wrapper, host, port, transport, blocking, false, timeout);
+
+	dictionary upgrade_headers = headers;
+
+	upgrade_headers["Sec-WebSocket-Key"] = generateRandomBase64String(16);
+
+	http::httpResponse response;
+
+	{
+		//the settings can change on the consumer thread while the maintenance thread connects
+		std::lock_guard<std::mutex> guard(standby_mutex);
+
+		socket->setHeartbeat(heartbeat_ping_ms, heartbeat_stale_ms);
+		socket->setWaitStrategy(wait_strategy);
+	}
+
+	socket->reInit();
+	socket->open(upgrade_headers, path.c_str(), response);
+
+	if (response.status_code != 101) throw exceptions::exception("Could not open the websocket connection - received status code " + std::to_string(response.status_code) + '.');
+
+	return socket;
+}
+
+void feedConnection::start()
+{
+	if (running) return;
+
+	primary_socket = connectSocket();
+	running = true;
+	maintenance_thread = std::thread(&feedConnection::maintain, this);
+}
+
+void feedConnection::stop()
+{
+	{
+		std::lock_guard<std::mutex> guard(standby_mutex);
+
+		running = false;
+	}
+
+	maintenance_signal.notify_all();
+
+	if (maintenance_thread.joinable()) maintenance_thread.join();
+
+	standby_socket.reset();
+	retired_sockets.clear();
+	primary_socket.reset();
+}
+
+void feedConnection::subscribe(const std::string& message, const char header)
+{
+	subscriptions.emplace_back(message, header);
+
+	primary_socket->send(message, header);
+}
+
+void feedConnection::clearSubscriptions()
+{
+	subscriptions.clear();
+}
+
+void feedConnection::setHeartbeat(const int ping_interval_ms, const int stale_after_ms)
+{
+	std::lock_guard<std::mutex> guard(standby_mutex);
+
+	heartbeat_ping_ms = ping_interval_ms;
+	heartbeat_stale_ms = stale_after_ms;
+}
+
+void feedConnection::setWaitStrategy(const waitStrategy& strategy)
+{
+	std::lock_guard<std::mutex> guard(standby_mutex);
+
+	wait_strategy = strategy;
+}
+
+int feedConnection::send(const std::string& message, const char header)
+{
+	return primary_socket->send(message, header);
+}
+
+bool feedConnection::recv(std::string& message)
+{
+	try { return primary_socket->recv(message); }
+	catch (const SSLNoReturn&) {} //the server closed the connection
+	catch (const std::exception&) {} //the connection broke or timed out
+
+	failover();
+
+	return false;
+}
+
+websocket& feedConnection::primary()
+{
+	return *primary_socket;
+}
+
+bool feedConnection::has_standby()
+{
+	std::lock_guard<std::mutex> guard(standby_mutex);
+
+	return standby_socket != nullptr;
+}
+
+uint64_t feedConnection::failover_count() const noexcept
+{
+	return failovers.load(std::memory_order_relaxed);
+}
+
+void feedConnection::failover()
+{
+	std::unique_ptr<websocket> replacement;
+
+	{
+		std::lock_guard<std::mutex> guard(standby_mutex);
+
+		replacement = std::move(standby_socket);
+	}
+
+	//the dead primary stays in place until the replacement is subscribed - if this throws the next recv fails over again
+	try
+	{
+		if (!replacement) replacement = connectSocket(); //no standby was ready so connect on this thread
+
+		for (const auto& subscription : subscriptions) replacement->send(subscription.first, subscription.second);
+	}
+	catch (const std::exception&)
+	{
+		if (replacement)
+		{
+			std::lock_guard<std::mutex> guard(standby_mutex);
+
+			replacement->opened = false; //the replay failed so the connection is dead
+			retired_sockets.push_back(std::move(replacement));
+		}
+
+		maintenance_signal.notify_all(); //close the failed connection and build a new standby
+
+		throw;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(standby_mutex);
+
+		primary_socket->opened = false; //the connection is dead so don't try to send a close frame
+		retired_sockets.push_back(std::move(primary_socket));
+	}
+
+	primary_socket = std::move(replacement);
+
+	maintenance_signal.notify_all(); //close the dead connection and build a new standby
+
+	failovers.fetch_add(1, std::memory_order_relaxed);
+}
+
+void feedConnection::maintain()
+{
+	int64_t backoff_ms = min_backoff_ms;
+
+	std::unique_lock<std::mutex> lock(standby_mutex);
+
+	while (running)
+	{
+		std::vector<std::unique_ptr<websocket>> retired;
+		std::unique_ptr<websocket> standby;
+
+		bool failed = false;
+
+		//the standby is serviced in its slot so a failover never finds the slot empty - only data that has already arrived is read, so the lock is held briefly
+		if (standby_socket)
+		{
+			std::string discarded;
+
+			//answer pings and drop anything else the server sends before the standby is promoted
+			try
+			{
+				while (standby_socket->wait_readable(0)) standby_socket->recv(discarded);
+
+				standby_socket->heartbeat();
+			}
+			catch (const std::exception&) { retired.push_back(std::move(standby_socket)); } //the standby died so replace it
+		}
+
+		bool needs_standby = !standby_socket;
+
+		for (auto& socket : retired_sockets) retired.push_back(std::move(socket));
+
+		retired_sockets.clear();
+
+		//connections are closed and created without holding the lock so a failover never waits on this thread
+		lock.unlock();
+
+		retired.clear();
+
+		if (needs_standby)
+		{
+			try
+			{
+				standby = connectSocket();
+				backoff_ms = min_backoff_ms;
+			}
+			catch (const std::exception&) { failed = true; }
+		}
+
+		lock.lock();
+
+		if (standby) standby_socket = std::move(standby);
+
+		if (!running) break;
+
+		if (failed)
+		{
+			maintenance_signal.wait_for(lock, std::chrono::milliseconds(backoff_ms), [this] { return !running; });
+
+			backoff_ms = backoff_ms * 2 < max_backoff_ms ? backoff_ms * 2 : max_backoff_ms;
+		}
+		else maintenance_signal.wait_for(lock, std::chrono::milliseconds(FEED_UTILS_STANDBY_CHECK_MS), [this] { return !running || !retired_sockets.empty(); });
+	}
+}
@@ -0,0 +1,111 @@
+
+//managed websocket feed connections that fail over to a pre-connected standby instead of reconnecting while messages are lost
+
+#ifndef FEED_UTILS_H
+#define FEED_UTILS_H
+
+#define FEED_UTILS_STANDBY_CHECK_MS 100 //how often the standby is serviced (pings answered and closed connections replaced)
+
+#include "exceptUtils.h"
+#include "socketUtils.h"
+#include "httpUtils.h"
+#include "wsUtils.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*
+a websocket feed with a hot standby connection
+
+start connects and upgrades the primary connection on the calling thread and then starts a maintenance thread that ...
+	1) keeps a second connection connected and upgraded in reserve (the standby)
+	2) answers pings and discards anything the server sends on the standby before it is promoted
+	3) retries a failed standby connection with exponential backoff between min_backoff_ms and max_backoff_ms
+
+with the heartbeat on, the standby is also pinged and replaced when it stops answering
+when the primary connection fails, recv promotes the standby immediately, replays every subscription in the order it was made ...
+... and hands the dead connection to the maintenance thread to close so the caller never waits on it
+if no replacement can be connected and subscribed, recv throws and keeps the dead primary so the next call to recv fails over again
+
+recv, send, and subscribe must all be called from the same thread (the consumer)
+on non-windows platforms the program should ignore SIGPIPE since closing a dead tls connection can write to it
+*/
+
+class feedConnection
+{
+public:
+	feedConnection(const feedConnection&); //I have this to make sure that I am not using the copy constructor
+	feedConnection(const SSLContextWrapper&, const std::string, const std::string, const socketTransport, const dictionary&, const std::string, const bool, const time_t,
+		const int64_t, const int64_t); //host, port, transport, upgrade headers, path, blocking, timeout, min_backoff_ms, max_backoff_ms
+	~feedConnection();
+
+	feedConnection& operator=(const feedConnection&); //I have this to make sure that I am not using item assignment
+
+	void start(); //connect the primary connection and start maintaining the standby
+	void stop(); //stop the maintenance thread and close every connection
+
+	void subscribe(const std::string&, const char); //send a message on the primary connection and replay it on every future primary (authentication, subscriptions)
+	void clearSubscriptions(); //stop replaying the recorded messages (does not send anything)
+
+	/*
+	ping interval ms, stale after ms - every connection made after the call (safe while the feed runs) runs websocket::setHeartbeat with these ...
+	... so a primary that goes quiet fails over once the stale time passes and a quiet standby is replaced by the maintenance thread
+	*/
+	void setHeartbeat(const int, const int);
+	void setWaitStrategy(const waitStrategy&); //how every connection made after the call waits between empty reads (see SSLSocket::setWaitStrategy)
+
+	int send(const std::string&, const char); //send a message on the primary connection without recording it
+	bool recv(std::string&); //same as websocket::recv but fails over to the standby instead of throwing when the primary connection fails (throws only if the failover fails)
+
+	websocket& primary(); //the connection currently in use - changes after a failover
+
+	bool has_standby(); //true if a standby connection is ready
+	uint64_t failover_count() const noexcept;
+
+private:
+	std::unique_ptr<websocket> connectSocket(); //connect and upgrade a new connection
+	void failover(); //replace the primary connection with the standby (or a new connection if there isn't one)
+	void maintain(); //body of the maintenance thread
+
+	SSLContextWrapper& ssl_context_wrapper;
+
+	std::string host;
+	std::string port;
+	std::string path;
+
+	socketTransport transport;
+	dictionary headers;
+
+	bool blocking;
+	time_t timeout;
+
+	int64_t min_backoff_ms;
+	int64_t max_backoff_ms;
+
+	int heartbeat_ping_ms; //guarded by standby_mutex
+	int heartbeat_stale_ms; //guarded by standby_mutex
+
+	waitStrategy wait_strategy; //guarded by standby_mutex
+
+	std::vector<std::pair<std::string, char>> subscriptions; //messages replayed on every new primary connection
+
+	std::unique_ptr<websocket> primary_socket;
+	std::unique_ptr<websocket> standby_socket; //guarded by standby_mutex
+
+	std::vector<std::unique_ptr<websocket>> retired_sockets; //dead primaries waiting to be closed - guarded by standby_mutex
+
+	std::mutex standby_mutex;
+	std::condition_variable maintenance_signal;
+	std::thread maintenance_thread;
+
+	std::atomic<bool> running;
+	std::atomic<uint64_t> failovers;
+};
+
+#endif
@@ -0,0 +1,1059 @@
+
+#include "http2Utils.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace http;
+
+#define HTTP2_DATA 0x0
+#define HTTP2_HEADERS 0x1
+#define HTTP2_PRIORITY 0x2
+#define HTTP2_RST_STREAM 0x3
+#define HTTP2_SETTINGS 0x4
+#define HTTP2_PUSH_PROMISE 0x5
+#define HTTP2_PING 0x6
+#define HTTP2_GOAWAY 0x7
+#define HTTP2_WINDOW_UPDATE 0x8
+#define HTTP2_CONTINUATION 0x9
+
+#define HTTP2_FLAG_END_STREAM 0x1
+#define HTTP2_FLAG_ACK 0x1
+#define HTTP2_FLAG_END_HEADERS 0x4
+#define HTTP2_FLAG_PADDED 0x8
+#define HTTP2_FLAG_PRIORITY 0x20
+
+#define HTTP2_SETTINGS_HEADER_TABLE_SIZE 0x1
+#define HTTP2_SETTINGS_ENABLE_PUSH 0x2
+#define HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS 0x3
+#define HTTP2_SETTINGS_INITIAL_WINDOW_SIZE 0x4
+#define HTTP2_SETTINGS_MAX_FRAME_SIZE 0x5
+
+#define HTTP2_NO_ERROR 0x0
+#define HTTP2_CANCEL 0x8
+
+#define HTTP2_DEFAULT_WINDOW_SIZE 65535
+#define HTTP2_MAX_WINDOW_SIZE 0x7fffffff
+
+static const char connection_preface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+//RFC 7541 appendix A
+static const std::pair<std::string_view, std::string_view> static_table[] =
+{
+	{ ":authority", "" },
+	{ ":method", "GET" },
+	{ ":method", "POST" },
+	{ ":path", "/" },
+	{ ":path", "/index.html" },
+	{ ":scheme", "http" },
+	{ ":scheme", "https" },
+	{ ":status", "200" },
+	{ ":status", "204" },
+	{ ":status", "206" },
+	{ ":status", "304" },
+	{ ":status", "400" },
+	{ ":status", "404" },
+	{ ":status", "500" },
+	{ "accept-charset", "" },
+	{ "accept-encoding", "gzip, deflate" },
+	{ "accept-language", "" },
+	{ "accept-ranges", "" },
+	{ "accept", "" },
+	{ "access-control-allow-origin", "" },
+	{ "age", "" },
+	{ "allow", "" },
+	{ "authorization", "" },
+	{ "cache-control", "" },
+	{ "content-disposition", "" },
+	{ "content-encoding", "" },
+	{ "content-language", "" },
+	{ "content-length", "" },
+	{ "content-location", "" },
+	{ "content-range", "" },
+	{ "content-type", "" },
+	{ "cookie", "" },
+	{ "date", "" },
+	{ "etag", "" },
+	{ "expect", "" },
+	{ "expires", "" },
+	{ "from", "" },
+	{ "host", "" },
+	{ "if-match", "" },
+	{ "if-modified-since", "" },
+	{ "if-none-match", "" },
+	{ "if-range", "" },
+	{ "if-unmodified-since", "" },
+	{ "last-modified", "" },
+	{ "link", "" },
+	{ "location", "" },
+	{ "max-forwards", "" },
+	{ "proxy-authenticate", "" },
+	{ "proxy-authorization", "" },
+	{ "range", "" },
+	{ "referer", "" },
+	{ "refresh", "" },
+	{ "retry-after", "" },
+	{ "server", "" },
+	{ "set-cookie", "" },
+	{ "strict-transport-security", "" },
+	{ "transfer-encoding", "" },
+	{ "user-agent", "" },
+	{ "vary", "" },
+	{ "via", "" },
+	{ "www-authenticate", "" }
+};
+
+static const size_t static_table_size = sizeof(static_table) / sizeof(static_table[0]);
+
+//RFC 7541 appendix B - bit lengths of the codes for bytes 0 - 255 and EOS (256)
+//the code is canonical, so the codes themselves follow from the lengths
+static const uint8_t huffman_lengths[257] =
+{
+	13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+	28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+	6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+	5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+	13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+	7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+	15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+	6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+	20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+	24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+	22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+	21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+	26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+	19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+	20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+	26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+	30
+};
+
+//canonical huffman decoding tables - a code of a given length is the first code of that length plus the symbol's rank among the symbols of that length
+struct huffmanTable
+{
+	uint32_t first_code[31] = {};
+	uint16_t count[31] = {};
+	uint16_t offset[31] = {};
+	uint16_t symbols[257] = {};
+
+	huffmanTable()
+	{
+		for (size_t symbol = 0; symbol < 257; ++symbol) ++count[huffman_lengths[symbol]];
+
+		uint32_t code = 0;
+		uint16_t position = 0;
+
+		for (size_t length = 1; length <= 30; ++length)
+		{
+			first_code[length] = code;
+			offset[length] = position;
+
+			code = (code + count[length]) << 1;
+			position += count[length];
+		}
+
+		uint16_t filled[31] = {};
+
+		//symbols of the same length are ranked in byte order
+		for (uint16_t symbol = 0; symbol < 257; ++symbol)
+		{
+			size_t length = huffman_lengths[symbol];
+
+			symbols[offset[length] + filled[length]++] = symbol;
+		}
+	}
+};
+
+static void huffmanDecode(const unsigned char* data, const size_t length, std::string& destination)
+{
+	static const huffmanTable table;
+
+	uint32_t code = 0;
+	size_t code_length = 0;
+
+	for (size_t index = 0; index < length; ++index)
+	{
+		for (int bit = 7; bit >= 0; --bit)
+		{
+			code = code << 1 | (data[index] >> bit & 1);
+			++code_length;
+
+			if (code_length > 30) throw exceptions::exception("Hpack string has an invalid huffman code.");
+
+			uint32_t rank = code - table.first_code[code_length];
+
+			if (code >= table.first_code[code_length] && rank < table.count[code_length])
+			{
+				uint16_t symbol = table.symbols[table.offset[code_length] + rank];
+
+				if (symbol == 256) throw exceptions::exception("Hpack string contains the huffman end of string code.");
+
+				destination.push_back(static_cast<char>(symbol));
+
+				code = 0;
+				code_length = 0;
+			}
+		}
+	}
+
+	//the last byte is padded with the most significant bits of the end of string code, which are all ones
+	if (code_length > 7 || code != (1u << code_length) - 1) throw exceptions::exception("Hpack string has invalid huffman padding.");
+}
+
+//integer with an n bit prefix - the bits above the prefix in the first byte carry the field's representation flags
+static void encodeInteger(uint64_t number, const int prefix_bits, const unsigned char first_byte_flags, std::string& block)
+{
+	const uint64_t limit = (1u << prefix_bits) - 1;
+
+	if (number < limit)
+	{
+		block.push_back(static_cast<char>(first_byte_flags | number));
+
+		return;
+	}
+
+	block.push_back(static_cast<char>(first_byte_flags | limit));
+	number -= limit;
+
+	while (number >= 0x80)
+	{
+		block.push_back(static_cast<char>((number & 0x7f) | 0x80));
+		number >>= 7;
+	}
+
+	block.push_back(static_cast<char>(number));
+}
+
+//strings are sent without huffman coding - request fields are short and the server's decoder takes either
+static void encodeString(const std::string_view text, std::string& block)
+{
+	encodeInteger(text.size(), 7, 0x00, block);
+
+	block.append(text);
+}
+
+void http::hpackEncode(const std::string_view name, const std::string_view value, std::string& block)
+{
+	size_t name_index = 0;
+
+	for (size_t index = 0; index < static_table_size; ++index)
+	{
+		if (static_table[index].first != name) continue;
+
+		if (static_table[index].second == value)
+		{
+			encodeInteger(index + 1, 7, 0x80, block); //indexed field
+
+			return;
+		}
+
+		if (!name_index) name_index = index + 1;
+	}
+
+	//literal field never indexed - the server's table is left alone so encoding needs no state
+	encodeInteger(name_index, 4, 0x10, block);
+
+	if (!name_index) encodeString(name, block);
+
+	encodeString(value, block);
+}
+
+http::hpackDecoder::hpackDecoder() : table_size(0), max_table_size(HTTP2_UTILS_HEADER_TABLE_SIZE) {}
+
+void http::hpackDecoder::reset()
+{
+	dynamic_table.clear();
+
+	table_size = 0;
+	max_table_size = HTTP2_UTILS_HEADER_TABLE_SIZE;
+}
+
+uint64_t http::hpackDecoder::decodeInteger(const unsigned char*& position, const unsigned char* end, const int prefix_bits)
+{
+	const uint64_t limit = (1u << prefix_bits) - 1;
+
+	uint64_t number = *position++ & limit;
+
+	if (number < limit) return number;
+
+	for (int shift = 0; ; shift += 7)
+	{
+		if (position == end || shift > 56) throw exceptions::exception("Hpack integer is truncated or too large.");
+
+		const unsigned char byte = *position++;
+
+		number += static_cast<uint64_t>(byte & 0x7f) << shift;
+
+		if (!(byte & 0x80)) return number;
+	}
+}
+
+void http::hpackDecoder::decodeString(const unsigned char*& position, const unsigned char* end, std::string& destination)
+{
+	if (position == end) throw exceptions::exception("Hpack string is truncated.");
+
+	const bool huffman = *position & 0x80;
+	const uint64_t length = decodeInteger(position, end, 7);
+
+	if (length > static_cast<uint64_t>(end - position)) throw exceptions::exception("Hpack string is truncated.");
+
+	destination.clear();
+
+	if (huffman) huffmanDecode(position, length, destination);
+	else destination.assign(reinterpret_cast<const char*>(position), length);
+
+	position += length;
+}
+
+void http::hpackDecoder::insert(const std::string& entry_name, const std::string& entry_value)
+{
+	const size_t entry_size = entry_name.size() + entry_value.size() + 32;
+
+	while (!dynamic_table.empty() && table_size + entry_size > max_table_size)
+	{
+		table_size -= dynamic_table.back().first.size() + dynamic_table.back().second.size() + 32;
+		dynamic_table.pop_back();
+	}
+
+	//an entry larger than the whole table just empties it
+	if (entry_size > max_table_size) return;
+
+	dynamic_table.emplace_front(entry_name, entry_value);
+	table_size += entry_size;
+}
+
+void http::hpackDecoder::decode(const char* block, const size_t length, std::string& destination, int& status_code)
+{
+	const unsigned char* position = reinterpret_cast<const unsigned char*>(block);
+	const unsigned char* end = position + length;
+
+	while (position < end)
+	{
+		const unsigned char byte = *position;
+
+		if ((byte & 0xe0) == 0x20) //dynamic table size update
+		{
+			uint64_t size = decodeInteger(position, end, 5);
+
+			if (size > HTTP2_UTILS_HEADER_TABLE_SIZE) throw exceptions::exception("Hpack table size update is larger than the advertised limit.");
+
+			max_table_size = static_cast<size_t>(size);
+
+			while (!dynamic_table.empty() && table_size > max_table_size)
+			{
+				table_size -= dynamic_table.back().first.size() + dynamic_table.back().second.size() + 32;
+				dynamic_table.pop_back();
+			}
+
+			continue;
+		}
+
+		uint64_t index;
+		bool add_to_table = false;
+
+		if (byte & 0x80) index = decodeInteger(position, end, 7); //indexed field
+		else
+		{
+			add_to_table = byte & 0x40; //literal with incremental indexing - otherwise without indexing or never indexed
+
+			index = decodeInteger(position, end, add_to_table ? 6 : 4);
+		}
+
+		if (index)
+		{
+			if (index <= static_table_size)
+			{
+				name.assign(static_table[index - 1].first);
+				value.assign(static_table[index - 1].second);
+			}
+			else if (index - static_table_size <= dynamic_table.size())
+			{
+				const std::pair<std::string, std::string>& entry = dynamic_table[index - static_table_size - 1];
+
+				name.assign(entry.first);
+				value.assign(entry.second);
+			}
+			else throw exceptions::exception("Hpack field index " + std::to_string(index) + " is out of range.");
+		}
+		else if (byte & 0x80) throw exceptions::exception("Hpack field index 0 is not allowed.");
+		else decodeString(position, end, name); //literal name
+
+		if (!(byte & 0x80)) decodeString(position, end, value);
+
+		if (add_to_table) insert(name, value);
+
+		if (name == ":status")
+		{
+			int code = 0;
+
+			for (const char digit : value) code = code * 10 + (digit - '0');
+
+			status_code = code;
+		}
+		else if (name.empty() || name[0] != ':')
+		{
+			destination.append(name);
+			destination.append(": ");
+			destination.append(value);
+			destination.append("\r\n");
+		}
+	}
+}
+
+//true for the http/1.1 fields that http/2 forbids - Host is sent as :authority instead
+static bool connectionSpecific(const std::string& lower_name)
+{
+	return lower_name == "connection" || lower_name == "keep-alive" || lower_name == "proxy-connection" || lower_name == "transfer-encoding" ||
+		lower_name == "upgrade" || lower_name == "host";
+}
+
+static inline void writeUint32(char* destination, const uint32_t number)
+{
+	destination[0] = static_cast<char>(number >> 24);
+	destination[1] = static_cast<char>(number >> 16);
+	destination[2] = static_cast<char>(number >> 8);
+	destination[3] = static_cast<char>(number);
+}
+
+static inline uint32_t readUint32(const char* source)
+{
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(source);
+
+	return static_cast<uint32_t>(bytes[0]) << 24 | static_cast<uint32_t>(bytes[1]) << 16 | static_cast<uint32_t>(bytes[2]) << 8 | bytes[3];
+}
+
+http::http2Client::http2Client(const http2Client& other_client) : ssl_socket(other_client.ssl_socket)
+{
+	throw std::runtime_error("http2Client type doesn't support copy construction.");
+}
+
+http::http2Client::http2Client(const SSLContextWrapper& ssl_context_wrapper, const std::string Host, const std::string Port, const socketTransport Transport,
+	const bool blocking, const time_t Timeout)
+	: ssl_socket(ssl_context_wrapper, Host, Port, Transport, blocking), authority(ssl_socket.get_host_header()), scheme(Transport == socketTransport::TLS ? "https" : "http"),
+	timeout(Timeout), next_stream_id(1), active_streams(0), continuation_stream(0), continuation_end_stream(false), connection_send_window(HTTP2_DEFAULT_WINDOW_SIZE),
+	initial_send_window(HTTP2_DEFAULT_WINDOW_SIZE), connection_unacknowledged(0), peer_max_frame_size(HTTP2_UTILS_MAX_FRAME_SIZE),
+	peer_max_streams(HTTP2_UTILS_MAX_STREAMS), going_away(false), input_start(0), input_end(0)
+{
+	ssl_socket.setAlpnProtocols({ "h2" });
+}
+
+http::http2Client::~http2Client() {}
+
+http2Client& http::http2Client::operator=(const http2Client& other_client)
+{
+	throw std::runtime_error("http2Client type doesn't support item assignment.");
+}
+
+void http::http2Client::reConnect()
+{
+	ssl_socket.reInit();
+
+	if (ssl_socket.get_transport() == socketTransport::TLS && ssl_socket.get_alpn() != "h2") throw exceptions::exception("The server did not negotiate http/2.");
+
+	decoder.reset();
+	streams.clear();
+	stream_queue.clear();
+
+	next_stream_id = 1;
+	active_streams = 0;
+
+	continuation_stream = 0;
+	header_block.clear();
+
+	connection_send_window = HTTP2_DEFAULT_WINDOW_SIZE;
+	initial_send_window = HTTP2_DEFAULT_WINDOW_SIZE;
+	connection_unacknowledged = 0;
+
+	peer_max_frame_size = HTTP2_UTILS_MAX_FRAME_SIZE;
+	peer_max_streams = HTTP2_UTILS_MAX_STREAMS;
+
+	going_away = false;
+
+	input_start = input_end = 0;
+
+	output.assign(connection_preface, sizeof(connection_preface) - 1);
+
+	//no server push and a large window for every stream - the connection's own window can only grow through a window update
+	char settings[12];
+
+	settings[0] = 0;
+	settings[1] = HTTP2_SETTINGS_ENABLE_PUSH;
+	writeUint32(settings + 2, 0);
+
+	settings[6] = 0;
+	settings[7] = HTTP2_SETTINGS_INITIAL_WINDOW_SIZE;
+	writeUint32(settings + 8, HTTP2_UTILS_WINDOW_SIZE);
+
+	writeFrame(HTTP2_SETTINGS, 0, 0, settings, sizeof(settings));
+	writeWindowUpdate(0, HTTP2_UTILS_WINDOW_SIZE - HTTP2_DEFAULT_WINDOW_SIZE);
+
+	flush();
+}
+
+void http::http2Client::get(httpResponse& response, const dictionary& parameters, const dictionary& headers, const std::string& path)
+{
+	awaitResponse(get(parameters, headers, path), response);
+}
+
+void http::http2Client::post(httpResponse& response, const dictionary& parameters, const dictionary& headers, const std::string& path, const std::string& body)
+{
+	awaitResponse(post(parameters, headers, path, body), response);
+}
+
+void http::http2Client::patch(httpResponse& response, const dictionary& parameters, const dictionary& headers, const std::string& path, const std::string& body)
+{
+	awaitResponse(patch(parameters, headers, path, body), response);
+}
+
+void http::http2Client::del(httpResponse& response, const dictionary& parameters, const dictionary& headers, const std::string& path)
+{
+	awaitResponse(del(parameters, headers, path), response);
+}
+
+uint32_t http::http2Client::get(const dictionary& parameters, const dictionary& headers, const std::string& path)
+{
+	return openStream(parameters, headers, path, "GET", std::string());
+}
+
+uint32_t http::http2Client::post(const dictionary& parameters, const dictionary& headers, const std::string& path, const std::string& body)
+{
+	return openStream(parameters, headers, path, "POST", body);
+}
+
+uint32_t http::http2Client::patch(const dictionary& parameters, const dictionary& headers, const std::string& path, const std::string& body)
+{
+	return openStream(parameters, headers, path, "PATCH", body);
+}
+
+uint32_t http::http2Client::del(const dictionary& parameters, const dictionary& headers, const std::string& path)
+{
+	return openStream(parameters, headers, path, "DELETE", std::string());
+}
+
+const socketStats& http::http2Client::get_stats() const noexcept
+{
+	return ssl_socket.get_stats();
+}
+
+void http::http2Client::setWaitStrategy(const waitStrategy& strategy)
+{
+	ssl_socket.setWaitStrategy(strategy);
+}
+
+uint32_t http::http2Client::openStream(const dictionary& parameters, const dictionary& headers, const std::string& path, const char* method, const std::string& body)
+{
+	if (!ssl_socket.is_connected()) throw std::runtime_error("The http2 client must be connected before making a request.");
+	if (going_away) throw exceptions::exception("The server is closing the http2 connection - reconnect before making another request.");
+	if (next_stream_id > HTTP2_MAX_WINDOW_SIZE) throw exceptions::exception("The http2 connection has run out of stream ids - reconnect before making another request.");
+
+	const uint32_t stream_id = next_stream_id;
+
+	next_stream_id += 2; //client streams are odd
+
+	http2Stream& stream = streams[stream_id];
+
+	//the path and query go out as :path - the rest of the request line and Host become pseudo fields
+	request = path;
+
+	if (!parameters.empty())
+	{
+		request.push_back('?');
+
+		for (const auto& pair : parameters) request.append(pair.first + "=" + pair.second + "&");
+
+		request.pop_back();
+	}
+
+	hpackEncode(":method", method, stream.header_block);
+	hpackEncode(":scheme", scheme, stream.header_block);
+	hpackEncode(":authority", authority, stream.header_block);
+	hpackEncode(":path", request, stream.header_block);
+
+	//field names must be lower case in http/2
+	for (const auto& pair : headers)
+	{
+		request.assign(pair.first);
+
+		std::transform(request.begin(), request.end(), request.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+		if (!connectionSpecific(request) && request != "content-length") hpackEncode(request, pair.second, stream.header_block);
+	}
+
+	if (!body.empty()) hpackEncode("content-length", std::to_string(body.size()), stream.header_block);
+
+	stream.body.assign(body);
+	stream.last_activity = time(nullptr);
+	stream.start_ns = steadyNanoseconds();
+
+	stream_queue.push_back(stream_id);
+
+	startStreams();
+	flush();
+
+	return stream_id;
+}
+
+void http::http2Client::startStreams()
+{
+	if (going_away) return; //the server will not process new streams after goaway
+
+	//streams are opened in id order - the server rejects a stream id lower than one it has already seen
+	while (!stream_queue.empty() && active_streams < peer_max_streams)
+	{
+		const uint32_t stream_id = stream_queue.front();
+
+		stream_queue.pop_front();
+
+		http2Stream& stream = streams[stream_id];
+
+		const bool end_stream = stream.body.empty();
+
+		//a header block larger than a frame continues in CONTINUATION frames
+		size_t sent = std::min(stream.header_block.size(), peer_max_frame_size);
+
+		writeFrame(HTTP2_HEADERS, (end_stream ? HTTP2_FLAG_END_STREAM : 0) | (sent == stream.header_block.size() ? HTTP2_FLAG_END_HEADERS : 0), stream_id, stream.header_block.data(), sent);
+
+		while (sent < stream.header_block.size())
+		{
+			size_t fragment = std::min(stream.header_block.size() - sent, peer_max_frame_size);
+
+			writeFrame(HTTP2_CONTINUATION, sent + fragment == stream.header_block.size() ? HTTP2_FLAG_END_HEADERS : 0, stream_id, stream.header_block.data() + sent, fragment);
+
+			sent += fragment;
+		}
+
+		std::string().swap(stream.header_block);
+
+		stream.opened = true;
+		stream.send_window = initial_send_window;
+		stream.last_activity = time(nullptr);
+
+		++active_streams;
+	}
+
+	sendBodies();
+}
+
+void http::http2Client::sendBodies()
+{
+	for (auto& [stream_id, stream] : streams)
+	{
+		if (connection_send_window <= 0) return;
+		if (!stream.opened || stream.complete) continue;
+
+		while (stream.body_sent < stream.body.size() && connection_send_window > 0 && stream.send_window > 0)
+		{
+			size_t length = std::min<size_t>({ stream.body.size() - stream.body_sent, peer_max_frame_size,
+				static_cast<size_t>(std::min(connection_send_window, stream.send_window)) });
+
+			stream.body_sent += length;
+
+			writeFrame(HTTP2_DATA, stream.body_sent == stream.body.size() ? HTTP2_FLAG_END_STREAM : 0, stream_id, stream.body.data() + stream.body_sent - length, length);
+
+			connection_send_window -= length;
+			stream.send_window -= length;
+		}
+	}
+}
+
+void http::http2Client::completeStream(http2Stream& stream)
+{
+	if (stream.complete) return;
+
+	stream.complete = true;
+
+	if (stream.opened) --active_streams;
+
+	std::string().swap(stream.body);
+
+	startStreams(); //a slot opened up for a queued stream
+}
+
+void http::http2Client::awaitResponse(const uint32_t stream_id, httpResponse& response)
+{
+	while (true)
+	{
+		uint64_t empty_reads = ssl_socket.get_stats().want_read.get();
+
+		status current_status = recvResponse(stream_id, response);
+
+		if (current_status == status::RECEIVED_RESPONSE || current_status == status::TIMED_OUT) return;
+
+		if (ssl_socket.get_stats().want_read.get() != empty_reads) ssl_socket.idle();
+	}
+}
+
+status http::http2Client::recvResponse(const uint32_t stream_id, httpResponse& response)
+{
+	auto found = streams.find(stream_id);
+
+	if (found == streams.end()) throw std::runtime_error("Unknown http2 stream " + std::to_string(stream_id) + '.');
+
+	//frames for every stream are handled here, so other streams make progress too
+	if (!found->second.complete) process();
+
+	http2Stream& stream = found->second;
+
+	if (!stream.complete)
+	{
+		if (time(nullptr) - stream.last_activity < timeout) return stream.headers_received ? status::RECEIVING_BODY : status::RECEIVING_HEADER;
+
+		//give up on the stream without affecting the others
+		if (stream.opened)
+		{
+			char error_code[4];
+
+			writeUint32(error_code, HTTP2_CANCEL);
+			writeFrame(HTTP2_RST_STREAM, 0, stream_id, error_code, 4);
+
+			completeStream(stream);
+			flush();
+		}
+		else stream_queue.erase(std::find(stream_queue.begin(), stream_queue.end(), stream_id));
+
+		streams.erase(found);
+
+		return status::TIMED_OUT;
+	}
+
+	if (!stream.error.empty())
+	{
+		std::string error = std::move(stream.error);
+
+		streams.erase(found);
+
+		throw exceptions::exception(error);
+	}
+
+	std::swap(response, stream.response); //the caller's old buffers go back into the stream and are freed with it
+
+	ssl_socket.get_stats().request_to_response.record(steadyNanoseconds() - stream.start_ns);
+
+	streams.erase(found);
+
+	return status::RECEIVED_RESPONSE;
+}
+
+bool http::http2Client::process()
+{
+	//move the unparsed bytes to the front once a whole frame might not fit behind them
+	if (input_start == input_end) input_start = input_end = 0;
+	else if (HTTP2_UTILS_BUFFER_SIZE - input_end < HTTP2_UTILS_MAX_FRAME_SIZE + HTTP2_UTILS_FRAME_HEADER_SIZE)
+	{
+		memmove(input, input + input_start, input_end - input_start);
+
+		input_end -= input_start;
+		input_start = 0;
+	}
+
+	int bytes = ssl_socket.read(input + input_end, static_cast<int>(HTTP2_UTILS_BUFFER_SIZE - input_end));
+
+	if (!bytes) return false;
+
+	input_end += bytes;
+
+	while (input_end - input_start >= HTTP2_UTILS_FRAME_HEADER_SIZE)
+	{
+		const unsigned char* header = reinterpret_cast<const unsigned char*>(input + input_start);
+
+		const size_t length = static_cast<size_t>(header[0]) << 16 | static_cast<size_t>(header[1]) << 8 | header[2];
+
+		if (length > HTTP2_UTILS_MAX_FRAME_SIZE) throw exceptions::exception("Http2 frame is larger than the maximum frame size.");
+		if (input_end - input_start < HTTP2_UTILS_FRAME_HEADER_SIZE + length) break;
+
+		handleFrame(header[3], header[4], readUint32(input + input_start + 5) & HTTP2_MAX_WINDOW_SIZE, input + input_start + HTTP2_UTILS_FRAME_HEADER_SIZE, length);
+
+		input_start += HTTP2_UTILS_FRAME_HEADER_SIZE + length;
+	}
+
+	flush(); //acknowledgements, window updates, and bodies the frames let through
+
+	return true;
+}
+
+void http::http2Client::handleFrame(const uint8_t type, const uint8_t flags, const uint32_t stream_id, const char* payload, size_t length)
+{
+	//a header block has to be finished before any other frame
+	if (continuation_stream && (type != HTTP2_CONTINUATION || stream_id != continuation_stream)) throw exceptions::exception("Http2 header block was interrupted by another frame.");
+
+	auto found = streams.find(stream_id);
+	http2Stream* stream = stream_id && found != streams.end() && !found->second.complete ? &found->second : nullptr;
+
+	if (stream) stream->last_activity = time(nullptr);
+
+	//padding is counted by flow control but is not part of the payload
+	if ((type == HTTP2_DATA || type == HTTP2_HEADERS) && flags & HTTP2_FLAG_PADDED)
+	{
+		if (!length || static_cast<unsigned char>(payload[0]) >= length) throw exceptions::exception("Http2 frame padding is larger than the frame.");
+
+		length -= static_cast<unsigned char>(payload[0]) + 1;
+		++payload;
+	}
+
+	switch (type)
+	{
+		case HTTP2_DATA:
+		{
+			const size_t frame_length = length + (flags & HTTP2_FLAG_PADDED ? static_cast<unsigned char>(payload[-1]) + 1 : 0);
+
+			if (stream) stream->response.message.append(payload, length);
+
+			//data is acknowledged in large window updates instead of one per frame
+			connection_unacknowledged += frame_length;
+
+			if (connection_unacknowledged >= HTTP2_UTILS_WINDOW_SIZE / 2)
+			{
+				writeWindowUpdate(0, static_cast<uint32_t>(connection_unacknowledged));
+
+				connection_unacknowledged = 0;
+			}
+
+			if (!stream) break;
+
+			if (flags & HTTP2_FLAG_END_STREAM) completeStream(*stream);
+			else if ((stream->unacknowledged += frame_length) >= HTTP2_UTILS_WINDOW_SIZE / 2)
+			{
+				writeWindowUpdate(stream_id, static_cast<uint32_t>(stream->unacknowledged));
+
+				stream->unacknowledged = 0;
+			}
+
+			break;
+		}
+		case HTTP2_HEADERS:
+		{
+			if (flags & HTTP2_FLAG_PRIORITY)
+			{
+				if (length < 5) throw exceptions::exception("Http2 headers frame is too short for its priority fields.");
+
+				payload += 5;
+				length -= 5;
+			}
+
+			header_block.assign(payload, length);
+
+			if (flags & HTTP2_FLAG_END_HEADERS) handleHeaderBlock(stream_id, flags & HTTP2_FLAG_END_STREAM);
+			else
+			{
+				continuation_stream = stream_id;
+				continuation_end_stream = flags & HTTP2_FLAG_END_STREAM;
+			}
+
+			break;
+		}
+		case HTTP2_CONTINUATION:
+		{
+			if (!continuation_stream) throw exceptions::exception("Http2 continuation frame does not follow a header block.");
+
+			header_block.append(payload, length);
+
+			if (flags & HTTP2_FLAG_END_HEADERS)
+			{
+				continuation_stream = 0;
+
+				handleHeaderBlock(stream_id, continuation_end_stream);
+			}
+
+			break;
+		}
+		case HTTP2_RST_STREAM:
+		{
+			if (length != 4) throw exceptions::exception("Http2 rst_stream frame has the wrong length.");
+
+			if (stream)
+			{
+				stream->error = "Http2 stream " + std::to_string(stream_id) + " was reset by the server with error code " + std::to_string(readUint32(payload)) + '.';
+
+				completeStream(*stream);
+			}
+
+			break;
+		}
+		case HTTP2_SETTINGS:
+		{
+			if (flags & HTTP2_FLAG_ACK) break;
+
+			handleSettings(payload, length);
+
+			break;
+		}
+		case HTTP2_PUSH_PROMISE: throw exceptions::exception("Http2 server pushed a stream even though push is disabled.");
+		case HTTP2_PING:
+		{
+			if (length != 8) throw exceptions::exception("Http2 ping frame has the wrong length.");
+
+			if (!(flags & HTTP2_FLAG_ACK)) writeFrame(HTTP2_PING, HTTP2_FLAG_ACK, 0, payload, 8);
+
+			break;
+		}
+		case HTTP2_GOAWAY:
+		{
+			if (length < 8) throw exceptions::exception("Http2 goaway frame is too short.");
+
+			const uint32_t last_stream_id = readUint32(payload) & HTTP2_MAX_WINDOW_SIZE;
+			const uint32_t error_code = readUint32(payload + 4);
+
+			going_away = true;
+
+			//queued streams are failed below and must not be opened by the slots their completion frees
+			stream_queue.clear();
+
+			//streams past the last one the server will process were never acted on and can be retried on a new connection
+			for (auto& [id, other_stream] : streams)
+			{
+				if ((id <= last_stream_id && other_stream.opened) || other_stream.complete) continue;
+
+				other_stream.error = "Http2 stream " + std::to_string(id) + " was not processed before the server closed the connection (error code " + std::to_string(error_code) + ").";
+
+				completeStream(other_stream);
+			}
+
+			break;
+		}
+		case HTTP2_WINDOW_UPDATE:
+		{
+			if (length != 4) throw exceptions::exception("Http2 window_update frame has the wrong length.");
+
+			const int64_t increment = readUint32(payload) & HTTP2_MAX_WINDOW_SIZE;
+
+			if (!stream_id) connection_send_window += increment;
+			else if (stream) stream->send_window += increment;
+
+			if (connection_send_window > HTTP2_MAX_WINDOW_SIZE || (stream && stream->send_window > HTTP2_MAX_WINDOW_SIZE)) throw exceptions::exception("Http2 flow control window overflowed.");
+
+			sendBodies();
+
+			break;
+		}
+		default: break; //priority frames and unknown frame types are ignored
+	}
+}
+
+void http::http2Client::handleHeaderBlock(const uint32_t stream_id, const bool end_stream)
+{
+	int status_code = 0;
+
+	//every header block is decoded, even for a stream that is gone, so the dynamic table stays in step with the server's
+	header_lines.clear();
+	decoder.decode(header_block.data(), header_block.size(), header_lines, status_code);
+
+	auto found = streams.find(stream_id);
+
+	if (found == streams.end() || found->second.complete) return;
+
+	http2Stream& stream = found->second;
+
+	if (!stream.headers_received)
+	{
+		if (status_code >= 100 && status_code < 200) return; //an informational response comes before the real one
+
+		//the fields are laid out like an http/1.1 header so the typed fields and find work the same way
+		stream.response.header.assign("HTTP/2 ");
+		stream.response.header.append(std::to_string(status_code));
+		stream.response.header.append("\r\n");
+		stream.response.header.append(header_lines);
+
+		parseHeader(stream.response);
+
+		stream.headers_received = true;
+	}
+	else
+	{
+		//trailer fields are added to the header without changing the typed fields the body was received under
+		size_t trailer_start = stream.response.header.size();
+
+		stream.response.header.append(header_lines);
+
+		parseTrailer(stream.response, trailer_start);
+	}
+
+	if (end_stream) completeStream(stream);
+}
+
+void http::http2Client::handleSettings(const char* payload, const size_t length)
+{
+	if (length % 6) throw exceptions::exception("Http2 settings frame has the wrong length.");
+
+	for (size_t offset = 0; offset < length; offset += 6)
+	{
+		const uint16_t identifier = static_cast<uint16_t>(static_cast<unsigned char>(payload[offset]) << 8 | static_cast<unsigned char>(payload[offset + 1]));
+		const uint32_t setting = readUint32(payload + offset + 2);
+
+		switch (identifier)
+		{
+			case HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS: peer_max_streams = setting; break;
+			case HTTP2_SETTINGS_INITIAL_WINDOW_SIZE:
+			{
+				if (setting > HTTP2_MAX_WINDOW_SIZE) throw exceptions::exception("Http2 initial window size is too large.");
+
+				//the change applies to the windows of every open stream
+				const int64_t delta = static_cast<int64_t>(setting) - initial_send_window;
+
+				for (auto& [stream_id, stream] : streams) if (stream.opened && !stream.complete) stream.send_window += delta;
+
+				initial_send_window = setting;
+
+				break;
+			}
+			case HTTP2_SETTINGS_MAX_FRAME_SIZE:
+			{
+				if (setting < HTTP2_UTILS_MAX_FRAME_SIZE || setting > 16777215) throw exceptions::exception("Http2 maximum frame size is out of range.");
+
+				peer_max_frame_size = setting;
+
+				break;
+			}
+			default: break; //the header table size only limits an encoder that uses the dynamic table, which this one does not
+		}
+	}
+
+	writeFrame(HTTP2_SETTINGS, HTTP2_FLAG_ACK, 0, nullptr, 0);
+
+	startStreams();
+}
+
+void http::http2Client::writeFrame(const uint8_t type, const uint8_t flags, const uint32_t stream_id, const char* payload, const size_t length)
+{
+	char header[HTTP2_UTILS_FRAME_HEADER_SIZE];
+
+	header[0] = static_cast<char>(length >> 16);
+	header[1] = static_cast<char>(length >> 8);
+	header[2] = static_cast<char>(length);
+	header[3] = static_cast<char>(type);
+	header[4] = static_cast<char>(flags);
+
+	writeUint32(header + 5, stream_id);
+
+	output.append(header, HTTP2_UTILS_FRAME_HEADER_SIZE);
+
+	if (length) output.append(payload, length);
+}
+
+void http::http2Client::writeWindowUpdate(const uint32_t stream_id, const uint32_t increment)
+{
+	char payload[4];
+
+	writeUint32(payload, increment);
+	writeFrame(HTTP2_WINDOW_UPDATE, 0, stream_id, payload, 4);
+}
+
+void http::http2Client::flush()
+{
+	size_t delivered = 0;
+
+	time_t sec_since_epoch = time(nullptr);
+
+	while (delivered < output.size())
+	{
+		int bytes = ssl_socket.write(output.data() + delivered, static_cast<int>(std::min<size_t>(output.size() - delivered, INT_MAX)));
+
+		if (bytes)
+		{
+			delivered += bytes;
+			sec_since_epoch = time(nullptr);
+		}
+		else if (time(nullptr) - sec_since_epoch >= timeout) throw exceptions::exception("Timed out while writing http2 frames.");
+	}
+
+	output.clear();
+}
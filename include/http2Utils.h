@@ -0,0 +1,177 @@
+
+//an http/2 client (RFC 9113) with hpack header compression (RFC 7541) - many concurrent requests share one connection
+
+#ifndef HTTP2_UTILS_H
+#define HTTP2_UTILS_H
+
+#define HTTP2_UTILS_FRAME_HEADER_SIZE 9
+#define HTTP2_UTILS_MAX_FRAME_SIZE 16384 //largest frame payload accepted - the protocol default, so it is never advertised
+#define HTTP2_UTILS_BUFFER_SIZE 65536 //receive buffer - always has room for a whole frame once parsed frames are moved out
+#define HTTP2_UTILS_WINDOW_SIZE 16777216 //receive window of the connection and of every stream - responses stream without waiting on window updates
+#define HTTP2_UTILS_HEADER_TABLE_SIZE 4096 //hpack dynamic table size used by the decoder (the protocol default)
+#define HTTP2_UTILS_MAX_STREAMS 100 //concurrent streams assumed until the server's settings arrive
+
+#include "exceptUtils.h"
+#include "socketUtils.h"
+#include "httpUtils.h"
+
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace http
+{
+	//append a header field to an hpack header block - indexed if the static table has the pair, otherwise a literal that is never added to a table
+	void hpackEncode(const std::string_view, const std::string_view, std::string&); //name, value, block
+
+	/*
+	decodes hpack header blocks with the dynamic table they build up - one decoder per connection, fed every header block in order
+	fields are appended to a string as http/1.1 style "name: value\r\n" lines so the response can be parsed by parseHeader
+	:status is returned separately and the other pseudo fields are dropped
+	*/
+	class hpackDecoder
+	{
+	public:
+		hpackDecoder();
+
+		void reset(); //empty the dynamic table for a new connection
+		void decode(const char*, const size_t, std::string&, int&); //block, length, destination for the field lines, status code
+
+	private:
+		uint64_t decodeInteger(const unsigned char*&, const unsigned char*, const int); //position, end, prefix bits
+		void decodeString(const unsigned char*&, const unsigned char*, std::string&); //position, end, destination
+		void insert(const std::string&, const std::string&); //add an entry to the dynamic table and evict the oldest past the size limit
+
+		std::deque<std::pair<std::string, std::string>> dynamic_table; //newest first
+
+		size_t table_size; //sum of the entry sizes (name + value + 32)
+		size_t max_table_size;
+
+		std::string name;
+		std::string value;
+	};
+
+	/*
+	an http/2 connection to one host with the get, post, patch and del surface of httpClient
+	tls connections negotiate h2 with ALPN - plaintext transports assume the server speaks h2 (prior knowledge)
+
+	each request opens its own stream and returns the stream id - recvResponse(id, response) processes incoming frames for every stream ...
+	... and hands over the response once that stream is complete, so responses can be collected in any order
+	requests past the server's limit on concurrent streams are queued and opened as earlier streams finish
+	request bodies are sent as the flow control windows allow and received data is acknowledged in large window updates
+	server push is disabled
+	a connection error or a closed connection throws - reConnect before making more requests
+	*/
+	class http2Client
+	{
+	public:
+		http2Client(const http2Client&);
+		http2Client(const SSLContextWrapper&, const std::string, const std::string, const socketTransport, const bool, const time_t); //host, port, transport, blocking, timeout
+		~http2Client();
+
+		http2Client& operator=(const http2Client&);
+
+		void reConnect(); //connect, check that h2 was negotiated, and send the connection preface and settings
+
+		//individual requests - wait for their own response while frames for other streams keep being handled
+		void get(httpResponse&, const dictionary&, const dictionary&, const std::string&);
+		void post(httpResponse&, const dictionary&, const dictionary&, const std::string&, const std::string&);
+		void patch(httpResponse&, const dictionary&, const dictionary&, const std::string&, const std::string&);
+		void del(httpResponse&, const dictionary&, const dictionary&, const std::string&);
+
+		//concurrent requests - open a stream (the body is copied) and return its id
+		uint32_t get(const dictionary&, const dictionary&, const std::string&);
+		uint32_t post(const dictionary&, const dictionary&, const std::string&, const std::string&);
+		uint32_t patch(const dictionary&, const dictionary&, const std::string&, const std::string&);
+		uint32_t del(const dictionary&, const dictionary&, const std::string&);
+
+		status recvResponse(const uint32_t, httpResponse&); //stream id, response - RECEIVED_RESPONSE once the response has been moved into the object
+
+		inline size_t open_streams() const noexcept { return active_streams; } //streams sent and not yet complete
+		inline size_t queued_streams() const noexcept { return stream_queue.size(); } //streams waiting for the server's concurrency limit
+		inline size_t max_streams() const noexcept { return peer_max_streams; } //the server's limit on concurrent streams
+
+		const socketStats& get_stats() const noexcept; //safe to read from a monitoring thread
+		void setWaitStrategy(const waitStrategy&); //how the individual requests wait for data (see SSLSocket::setWaitStrategy)
+
+	private:
+		struct http2Stream
+		{
+			httpResponse response;
+
+			std::string header_block; //encoded request header - kept until the stream is opened
+			std::string body;
+			size_t body_sent = 0;
+
+			int64_t send_window = 0;
+			int64_t unacknowledged = 0; //bytes received since the last window update for the stream
+
+			bool opened = false;
+			bool headers_received = false;
+			bool complete = false;
+
+			std::string error; //set when the stream failed - thrown by recvResponse
+
+			time_t last_activity = 0;
+			int64_t start_ns = 0;
+		};
+
+		uint32_t openStream(const dictionary&, const dictionary&, const std::string&, const char*, const std::string&); //parameters, headers, path, method, body
+		void awaitResponse(const uint32_t, httpResponse&);
+
+		void startStreams(); //send the headers of queued streams while the server allows more concurrent streams
+		void sendBodies(); //send as much of the request bodies as the flow control windows allow
+		void completeStream(http2Stream&);
+
+		bool process(); //read once and handle every complete frame - false if nothing was read
+		void handleFrame(const uint8_t, const uint8_t, const uint32_t, const char*, size_t); //type, flags, stream id, payload, length
+		void handleHeaderBlock(const uint32_t, const bool); //stream id, end of stream
+		void handleSettings(const char*, const size_t);
+
+		void writeFrame(const uint8_t, const uint8_t, const uint32_t, const char*, const size_t); //type, flags, stream id, payload, length - appended to output
+		void writeWindowUpdate(const uint32_t, const uint32_t); //stream id, increment
+		void flush(); //write out every queued frame
+
+		SSLSocket ssl_socket;
+
+		std::string authority; //host (and port) for the :authority field
+		const char* scheme;
+
+		time_t timeout;
+
+		hpackDecoder decoder;
+
+		std::unordered_map<uint32_t, http2Stream> streams;
+		std::deque<uint32_t> stream_queue; //streams waiting to be opened, in id order
+
+		uint32_t next_stream_id;
+		size_t active_streams;
+
+		uint32_t continuation_stream; //stream whose header block is being continued (0 if none)
+		bool continuation_end_stream;
+		std::string header_block; //header block fragments being joined
+		std::string header_lines; //decoded fields of the last header block
+
+		int64_t connection_send_window;
+		int64_t initial_send_window; //the server's initial window for new streams
+		int64_t connection_unacknowledged;
+
+		size_t peer_max_frame_size;
+		size_t peer_max_streams;
+
+		bool going_away; //the server sent GOAWAY - no new streams
+
+		std::string output; //frames waiting to be written
+		std::string request; //reused while encoding a request
+
+		char input[HTTP2_UTILS_BUFFER_SIZE];
+		size_t input_start;
+		size_t input_end;
+	};
+}
+
+#endif
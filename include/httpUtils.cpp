@@ -1,15 +1,320 @@
 
 #include "httpUtils.h"
 
+#include <charconv>
+
 using namespace http;
 
+//ascii only - header field names are ascii
+static inline char lowerCase(const char c) noexcept
+{
+	return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+static bool equalsIgnoreCase(const std::string_view left, const std::string_view right) noexcept
+{
+	if (left.size() != right.size()) return false;
+
+	for (size_t index = 0; index < left.size(); ++index) if (lowerCase(left[index]) != lowerCase(right[index])) return false;
+
+	return true;
+}
+
+static bool containsIgnoreCase(const std::string_view text, const std::string_view token) noexcept
+{
+	for (size_t index = 0; index + token.size() <= text.size(); ++index) if (equalsIgnoreCase(text.substr(index, token.size()), token)) return true;
+
+	return false;
+}
+
+//-1 unless the whole value is a non-negative decimal number
+static int64_t parseInteger(const std::string_view value) noexcept
+{
+	int64_t number = -1;
+
+	const char* end = value.data() + value.size();
+	auto [position, error] = std::from_chars(value.data(), end, number);
+
+	return error == std::errc() && position == end && number >= 0 ? number : -1;
+}
+
+//fill the typed members of the response from the fields that drive the client
+static void recognizeField(httpResponse& response, std::string_view name, const std::string_view value) noexcept
+{
+	if (equalsIgnoreCase(name, "Content-Length")) response.content_length = parseInteger(value);
+	else if (equalsIgnoreCase(name, "Transfer-Encoding")) response.chunked = value.size() >= 7 && equalsIgnoreCase(value.substr(value.size() - 7), "chunked"); //chunked is always the last coding
+	else if (equalsIgnoreCase(name, "Connection")) response.close = containsIgnoreCase(value, "close");
+	else if (equalsIgnoreCase(name, "Content-Encoding")) response.encoded = equalsIgnoreCase(value, "gzip") || equalsIgnoreCase(value, "x-gzip") || equalsIgnoreCase(value, "deflate");
+	else if (equalsIgnoreCase(name, "Retry-After")) response.retry_after = parseInteger(value);
+	else
+	{
+		//rate limits are sent with and without the x- prefix
+		if (name.size() > 2 && equalsIgnoreCase(name.substr(0, 2), "x-")) name.remove_prefix(2);
+
+		if (equalsIgnoreCase(name, "RateLimit-Limit")) response.rate_limit = parseInteger(value);
+		else if (equalsIgnoreCase(name, "RateLimit-Remaining")) response.rate_limit_remaining = parseInteger(value);
+		else if (equalsIgnoreCase(name, "RateLimit-Reset")) response.rate_limit_reset = parseInteger(value);
+	}
+}
+
+std::string_view http::httpResponse::status_message() const noexcept
+{
+	return std::string_view(header.data() + status_start, status_length);
+}
+
+std::string_view http::httpResponse::field_name(const size_t index) const
+{
+	const httpField& field = fields[index];
+
+	return std::string_view(header.data() + field.name_start, field.name_length);
+}
+
+std::string_view http::httpResponse::field_value(const size_t index) const
+{
+	const httpField& field = fields[index];
+
+	return std::string_view(header.data() + field.value_start, field.value_length);
+}
+
+std::string_view http::httpResponse::find(const std::string_view name) const noexcept
+{
+	for (size_t index = 0; index < fields.size(); ++index)
+	{
+		const httpField& field = fields[index];
+
+		if (equalsIgnoreCase(std::string_view(header.data() + field.name_start, field.name_length), name)) return std::string_view(header.data() + field.value_start, field.value_length);
+	}
+
+	return std::string_view();
+}
+
+bool http::httpResponse::has(const std::string_view name) const noexcept
+{
+	for (size_t index = 0; index < fields.size(); ++index)
+	{
+		const httpField& field = fields[index];
+
+		if (equalsIgnoreCase(std::string_view(header.data() + field.name_start, field.name_length), name)) return true;
+	}
+
+	return false;
+}
+
 void http::httpResponse::clear()
 {
+	//clearing the strings keeps their capacity so a reused response does not allocate again
 	fields.clear();
-	status_message.clear();
+	header.clear();
 	message.clear();
 
 	status_code = 0;
+	status_start = status_length = 0;
+
+	content_length = -1;
+	chunked = false;
+	close = false;
+	encoded = false;
+
+	rate_limit = rate_limit_remaining = rate_limit_reset = retry_after = -1;
+}
+
+//record the field lines of the header from the given offset - recognize fills the typed fields from them
+static void parseFields(httpResponse& response, size_t line_start, const bool recognize)
+{
+	const std::string_view header(response.header);
+
+	size_t line_end;
+
+	while (line_start < header.size())
+	{
+		line_end = header.find("\r\n", line_start);
+
+		if (line_end == std::string_view::npos) line_end = header.size();
+
+		size_t colon = header.find(':', line_start);
+
+		if (colon < line_end)
+		{
+			//optional whitespace around the value is not part of it
+			size_t value_start = colon + 1;
+			size_t value_end = line_end;
+
+			while (value_start < value_end && (header[value_start] == ' ' || header[value_start] == '\t')) ++value_start;
+			while (value_end > value_start && (header[value_end - 1] == ' ' || header[value_end - 1] == '\t')) --value_end;
+
+			if (response.fields.size() >= HTTP_UTILS_MAX_FIELDS) throw exceptions::exception("Http response has more than " + std::to_string(HTTP_UTILS_MAX_FIELDS) + " header fields.");
+
+			response.fields.push_back(httpField{ static_cast<uint32_t>(line_start), static_cast<uint32_t>(colon - line_start),
+				static_cast<uint32_t>(value_start), static_cast<uint32_t>(value_end - value_start) });
+
+			if (recognize) recognizeField(response, header.substr(line_start, colon - line_start), header.substr(value_start, value_end - value_start));
+		}
+
+		line_start = line_end + 2;
+	}
+}
+
+void http::parseHeader(httpResponse& response)
+{
+	const std::string_view header(response.header);
+
+	size_t line_end = header.find("\r\n");
+
+	//status line - HTTP/1.1 200 OK
+	size_t code_start = header.find(' ');
+
+	if (line_end == std::string_view::npos || code_start >= line_end) throw exceptions::exception("Http response has a malformed status line.");
+
+	auto [code_end, error] = std::from_chars(header.data() + code_start + 1, header.data() + line_end, response.status_code);
+
+	if (error != std::errc()) throw exceptions::exception("Http response has a malformed status code.");
+
+	if (code_end < header.data() + line_end)
+	{
+		response.status_start = static_cast<uint32_t>(code_end - header.data() + 1);
+		response.status_length = static_cast<uint32_t>(line_end - response.status_start);
+	}
+
+	parseFields(response, line_end + 2, true);
+}
+
+void http::parseTrailer(httpResponse& response, const size_t trailer_start)
+{
+	parseFields(response, trailer_start, false);
+}
+
+//value of a hex digit or -1
+static inline int hexValue(const char c) noexcept
+{
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+
+	return -1;
+}
+
+void http::chunkedDecoder::reset() noexcept
+{
+	phase = chunkPhase::SIZE;
+
+	remaining = 0;
+	digits = 0;
+
+	trailer_fields.clear();
+}
+
+size_t http::chunkedDecoder::decode(const char* data, const size_t length, std::string& destination)
+{
+	size_t position = 0;
+
+	while (position < length && phase != chunkPhase::DONE)
+	{
+		const char c = data[position];
+
+		switch (phase)
+		{
+			case chunkPhase::SIZE:
+			{
+				int digit = hexValue(c);
+
+				if (digit >= 0)
+				{
+					if (remaining >> 60) throw exceptions::exception("Http chunk size is too large.");
+
+					remaining = remaining << 4 | static_cast<uint64_t>(digit);
+					++digits;
+				}
+				else if (!digits) throw exceptions::exception("Http chunk size is malformed.");
+				else phase = c == '\r' ? chunkPhase::SIZE_LF : chunkPhase::EXTENSION; //anything after the digits up to the line ending is an extension
+
+				++position;
+
+				break;
+			}
+			case chunkPhase::EXTENSION:
+			{
+				if (c == '\r') phase = chunkPhase::SIZE_LF;
+
+				++position;
+
+				break;
+			}
+			case chunkPhase::SIZE_LF:
+			{
+				if (c != '\n') throw exceptions::exception("Http chunk size line is malformed.");
+
+				phase = remaining ? chunkPhase::DATA : chunkPhase::TRAILER_START; //a chunk size of 0 indicates the end of the message
+				++position;
+
+				break;
+			}
+			case chunkPhase::DATA:
+			{
+				size_t available = std::min<uint64_t>(remaining, length - position);
+
+				destination.append(data + position, available);
+
+				position += available;
+				remaining -= available;
+
+				if (!remaining) phase = chunkPhase::DATA_CR;
+
+				break;
+			}
+			case chunkPhase::DATA_CR:
+			case chunkPhase::DATA_LF:
+			{
+				if (c != (phase == chunkPhase::DATA_CR ? '\r' : '\n')) throw exceptions::exception("Http chunk is not followed by a line ending.");
+
+				if (phase == chunkPhase::DATA_CR) phase = chunkPhase::DATA_LF;
+				else
+				{
+					phase = chunkPhase::SIZE;
+					digits = 0;
+				}
+
+				++position;
+
+				break;
+			}
+			case chunkPhase::TRAILER_START:
+			{
+				//an empty line ends the trailer - otherwise the byte starts a trailer field and is consumed by TRAILER
+				if (c == '\r')
+				{
+					phase = chunkPhase::END_LF;
+					++position;
+				}
+				else phase = chunkPhase::TRAILER;
+
+				break;
+			}
+			case chunkPhase::TRAILER:
+			{
+				if (trailer_fields.size() >= HTTP_UTILS_MAX_HEADER_SIZE) throw exceptions::exception("Http chunked trailer is larger than " + std::to_string(HTTP_UTILS_MAX_HEADER_SIZE) + " bytes.");
+
+				trailer_fields.push_back(c);
+
+				if (c == '\n') phase = chunkPhase::TRAILER_START;
+
+				++position;
+
+				break;
+			}
+			case chunkPhase::END_LF:
+			{
+				if (c != '\n') throw exceptions::exception("Http chunked body is not terminated by a blank line.");
+
+				phase = chunkPhase::DONE;
+				++position;
+
+				break;
+			}
+			case chunkPhase::DONE: break;
+		}
+	}
+
+	return position;
 }
 
 void http::constructRequest(const dictionary& parameters, const dictionary& headers, const std::string& host, const std::string& path,
@@ -35,16 +340,39 @@ void http::constructRequest(const dictionary& parameters, const dictionary& head
 	request.append("Host: " + host + "\r\n\r\n"); //request += "Host: " + host + "\r\n\r\n";
 }
 
+//append the bytes just read to the header - true once the blank line is found, with anything after it moved to response.message
+static bool appendHeader(httpResponse& response, const char* data, const size_t length)
+{
+	//only the new bytes and the three before them can complete the blank line, so the header is scanned once
+	size_t scan_start = response.header.size() < 3 ? 0 : response.header.size() - 3;
+
+	response.header.append(data, length);
+
+	size_t index = response.header.find("\r\n\r\n", scan_start);
+
+	if (index == std::string::npos)
+	{
+		if (response.header.size() > HTTP_UTILS_MAX_HEADER_SIZE) throw exceptions::exception("Http response header is larger than " + std::to_string(HTTP_UTILS_MAX_HEADER_SIZE) + " bytes.");
+
+		return false;
+	}
+
+	response.message.assign(response.header, index + 4);
+	response.header.resize(index + 2); //keep the line ending of the last field so every line is parsed the same way
+
+	http::parseHeader(response);
+
+	return true;
+}
+
 void http::parseResponseHeader(SSLSocket& ssl_socket, time_t timeout, httpResponse& response)
 {
 	char buffer[HTTP_UTILS_BUFFER_SIZE];
 	int bytes;
 
 	time_t sec_since_epoch = time(nullptr);
-	size_t index = 0;
 
-	std::string field;
-	std::string segment = "Status Code Info: ";
+	response.clear();
 
 	while (time(nullptr) - sec_since_epoch < timeout)
 	{
@@ -52,43 +380,14 @@ void http::parseResponseHeader(SSLSocket& ssl_socket, time_t timeout, httpRespon
 		
 		if (bytes > 0)
 		{
-			segment += std::string(&buffer[0], bytes); //read the memory addresses from buffer[0] to buffer[bytes]
-			index = segment.find("\r\n\r\n");
-
-			if (index != std::string::npos)
-			{
-				response.message = segment.substr(index + 4);
-				segment = segment.substr(0, index);
-
-				break;
-			}
+			if (appendHeader(response, buffer, bytes)) return;
 
 			sec_since_epoch = time(nullptr);
 		}
+		else ssl_socket.idle();
 	}
 
-	if (time(nullptr) - sec_since_epoch >= timeout) throw exceptions::exception("Http request timed out.");
-
-	index = segment.find("\r\n");
-
-	while (index != std::string::npos)
-	{
-		field = segment.substr(0, index);
-		segment = segment.substr(index + 2);
-		index = field.find(": ");
-
-		response.fields[field.substr(0, index)] = field.substr(index + 2);
-
-		index = segment.find("\r\n");
-	}
-
-	segment = response.fields["Status Code Info"].substr(9);
-	index = segment.find(" ");
-
-	response.status_code = std::stoi(segment.substr(0, index));
-	response.status_message = segment.substr(index + 1);
-
-	response.fields.erase("Status Code Info");
+	throw exceptions::exception("Http request timed out.");
 }
 
 void http::get(const SSLContextWrapper& ssl_context_wrapper, httpResponse& response, const dictionary& parameters, const dictionary& headers,\
@@ -127,156 +426,356 @@ void http::del(const SSLContextWrapper& ssl_context_wrapper, httpResponse& respo
 	client.del(response, parameters, headers, path);
 }
 
+typedef void (httpClient::*idempotentRequest)(httpResponse&, const dictionary&, const dictionary&, const std::string&);
+
+//a pooled connection the server dropped while it was idle fails with a clean close, a reset or a tls error ...
+//... the request is sent again on a new connection once, as long as none of the response arrived
+static void retryIdempotent(httpClient& client, const idempotentRequest request, httpResponse& response, const dictionary& parameters, const dictionary& headers, \
+	const std::string& path)
+{
+	try { (client.*request)(response, parameters, headers, path); return; }
+	catch (const SSLNoReturn&) { if (!response.header.empty()) throw; }
+	catch (const exceptions::exception&) { if (!response.header.empty()) throw; }
+
+	response.clear();
+
+	client.reConnect();
+	(client.*request)(response, parameters, headers, path);
+}
+
+void http::get(httpClientPool& pool, httpResponse& response, const dictionary& parameters, const dictionary& headers, \
+	const std::string& host, const std::string& path)
+{
+	std::unique_ptr<httpClient> client = pool.acquire(host);
+
+	retryIdempotent(*client, &httpClient::get, response, parameters, headers, path);
+
+	pool.release(std::move(client));
+}
+
+void http::post(httpClientPool& pool, httpResponse& response, const dictionary& parameters, const dictionary& headers, \
+	const std::string& host, const std::string& path, const std::string& body)
+{
+	std::unique_ptr<httpClient> client = pool.acquire(host);
+
+	client->post(response, parameters, headers, path, body); //never retried - the server may have already acted on the request
+
+	pool.release(std::move(client));
+}
+
+void http::patch(httpClientPool& pool, httpResponse& response, const dictionary& parameters, const dictionary& headers, \
+	const std::string& host, const std::string& path, const std::string& body)
+{
+	std::unique_ptr<httpClient> client = pool.acquire(host);
+
+	client->patch(response, parameters, headers, path, body); //never retried - the server may have already acted on the request
+
+	pool.release(std::move(client));
+}
+
+void http::del(httpClientPool& pool, httpResponse& response, const dictionary& parameters, const dictionary& headers, \
+	const std::string& host, const std::string& path)
+{
+	std::unique_ptr<httpClient> client = pool.acquire(host);
+
+	retryIdempotent(*client, &httpClient::del, response, parameters, headers, path);
+
+	pool.release(std::move(client));
+}
+
 http::httpClient::httpClient(const httpClient& other_client)
-	: ssl_socket(other_client.ssl_socket), host(other_client.host), timeout(other_client.timeout), current_status(status::RECEIVED_RESPONSE)
+	: ssl_socket(other_client.ssl_socket), host(other_client.host), timeout(other_client.timeout), inflater(ZLIB_UTILS_AUTO_HEADER), body_received(0), sniff_deflate(false), compression(other_client.compression),
+	current_status(status::RECEIVED_RESPONSE), keep_alive(false), close_requested(false), pipelining(false), responses_pending(0)
 {
 	bytes = 0;
 
 	sec_since_epoch = 0;
-	index = 0;
 
 	max_message_length = 0;
+	request_start_ns = 0;
 }
 
 http::httpClient::httpClient(const SSLContextWrapper& ssl_context_wrapper, const std::string Host, const bool blocking, const time_t Timeout)
-	: ssl_socket(ssl_context_wrapper, Host, blocking), host(Host), timeout(Timeout), current_status(status::RECEIVED_RESPONSE)
+	: httpClient(ssl_context_wrapper, Host, "443", socketTransport::TLS, blocking, Timeout) {}
+
+http::httpClient::httpClient(const SSLContextWrapper& ssl_context_wrapper, const std::string Host, const std::string Port, const socketTransport Transport,
+	const bool blocking, const time_t Timeout)
+	: ssl_socket(ssl_context_wrapper, Host, Port, Transport, blocking), host(ssl_socket.get_host_header()), timeout(Timeout), inflater(ZLIB_UTILS_AUTO_HEADER), body_received(0), sniff_deflate(false), compression(true),
+	current_status(status::RECEIVED_RESPONSE), keep_alive(false), close_requested(false), pipelining(false), responses_pending(0)
 {
 	bytes = 0;
 
 	sec_since_epoch = 0;
-	index = 0;
 
 	max_message_length = 0;
+	request_start_ns = 0;
 }
 
-http::httpClient::~httpClient() //this is a cheap way of (mostly) ensuring that keep-alive connections will be closed on the server side
+http::httpClient::~httpClient() {} //the socket sends close_notify and closes the connection - the server does not need an extra request
+
+httpClient& httpClient::operator=(const httpClient& other_client)
 {
-	if (ssl_socket.get_struct())
-	{
-		request.clear();
+	throw std::runtime_error("httpClient type doesn't support re-assignment.");
+}
 
-		dictionary parameters;
-		dictionary headers;
+void http::httpClient::reConnect()
+{
+	ssl_socket.reInit();
 
-		headers["Connection"] = "close";
+	current_status = status::RECEIVED_RESPONSE;
+	keep_alive = true;
 
-		http::httpResponse response;
+	responses_pending = 0;
+	unread.clear();
+}
 
-		try { get(response, parameters, headers, "/"); }
-		catch (const SSLNoReturn&) {}
-		catch (const std::exception&) {} //if the SSL socket is not initialized
-		catch (...) {}
-	}
+//true if the request headers ask the server to close the connection after responding
+static bool requestsClose(const dictionary& headers)
+{
+	auto connection = headers.find("Connection");
+
+	return connection != headers.end() && connection->second == "close";
 }
 
-httpClient& httpClient::operator=(const httpClient& other_client)
+const std::string& http::httpClient::get_host() const noexcept
 {
-	throw std::runtime_error("httpClient type doesn't support re-assignment.");
+	return host;
 }
 
-void http::httpClient::reConnect()
+bool http::httpClient::reusable() const noexcept
 {
-	ssl_socket.reInit();
+	return keep_alive && current_status == status::RECEIVED_RESPONSE && !responses_pending && ssl_socket.is_connected();
+}
 
-	current_status = status::RECEIVED_RESPONSE;
+bool http::httpClient::is_alive()
+{
+	return ssl_socket.is_alive();
 }
 
-void http::httpClient::get(httpResponse& response, const dictionary& parameters, const dictionary& headers, const std::string& path)
+void http::httpClient::setWaitStrategy(const waitStrategy& strategy)
 {
-	get(parameters, headers, path);
+	ssl_socket.setWaitStrategy(strategy);
+}
 
-	do recvResponse(response);
-	while (current_status != status::RECEIVED_RESPONSE && current_status != status::TIMED_OUT);
+void http::httpClient::setCompression(const bool enabled)
+{
+	compression = enabled;
 }
 
-void http::httpClient::get(const dictionary& parameters, const dictionary& headers, const std::string& path)
+void http::httpClient::acceptEncoding(const dictionary& headers, std::string& constructed_request)
 {
-	if (current_status != status::RECEIVED_RESPONSE && current_status != status::TIMED_OUT) throw std::runtime_error("Cannot make another http request while receiving a response.");
+	if (!compression || headers.count("Accept-Encoding")) return;
 
-	request.clear();
+	//inserted before the blank line that ends the request header
+	constructed_request.insert(constructed_request.size() - 2, "Accept-Encoding: gzip, deflate\r\n");
+}
 
-	constructRequest(parameters, headers, host, path, "GET", request);
+size_t http::httpClient::decodeChunks(const char* data, const size_t length, httpResponse& response)
+{
+	if (!response.encoded) return chunked_decoder.decode(data, length, response.message);
 
-	current_status = status::SEND_REQUEST;
+	encoded_body.clear();
+
+	size_t consumed = chunked_decoder.decode(data, length, encoded_body);
+
+	inflateBody(encoded_body.data(), encoded_body.size(), response);
+	body_received += encoded_body.size();
+
+	return consumed;
 }
 
-void http::httpClient::post(httpResponse& response, const dictionary& parameters, const dictionary& headers, const std::string& path, const std::string& body)
+void http::httpClient::resetInflater(const httpResponse& response)
 {
-	post(parameters, headers, path, body);
+	//a previous deflate body may have switched the stream to raw deflate
+	inflater.reset(ZLIB_UTILS_AUTO_HEADER);
 
-	do recvResponse(response);
-	while (current_status != status::RECEIVED_RESPONSE && current_status != status::TIMED_OUT);
+	sniff_deflate = equalsIgnoreCase(response.find("Content-Encoding"), "deflate");
 }
 
-void http::httpClient::post(const dictionary& parameters, const dictionary& headers, const std::string& path, const std::string& body)
+void http::httpClient::inflateBody(const char* data, const size_t length, httpResponse& response)
 {
-	if (current_status != status::RECEIVED_RESPONSE && current_status != status::TIMED_OUT) throw std::runtime_error("Cannot make another http request while receiving a response.");
+	if (sniff_deflate && length)
+	{
+		//a zlib header always starts with compression method 8 in the low nibble ...
+		//... which raw deflate only starts with for a non-final stored block with its padding bits set, something encoders do not write
+		if ((data[0] & 0x0f) != 8) inflater.reset(ZLIB_UTILS_RAW_DEFLATE);
+
+		sniff_deflate = false;
+	}
+
+	inflater.inflate(data, length, response.message);
+}
+
+void http::httpClient::checkIdle()
+{
+	if (current_status == status::TIMED_OUT)
+	{
+		//responses still owed to a pipeline would arrive ahead of the new request's response
+		if (pipelining && responses_pending) throw std::runtime_error("Cannot make another http request until reConnect drops the timed out pipeline.");
+
+		//the bytes left over from the timed out response are not the start of the next one
+		responses_pending = 0;
+		unread.clear();
+
+		return;
+	}
+
+	if (current_status != status::RECEIVED_RESPONSE || responses_pending) throw std::runtime_error("Cannot make another http request while receiving a response.");
+}
+
+void http::httpClient::prepareRequest(const dictionary& parameters, const dictionary& headers, const std::string& path, const char* method, const char* body, const size_t body_length)
+{
+	checkIdle();
 
 	request.clear();
 
-	constructRequest(parameters, headers, host, path, "POST", request);
+	constructRequest(parameters, headers, host, path, method, request);
+	acceptEncoding(headers, request);
+
+	close_requested = requestsClose(headers);
+	pipelining = false;
+	responses_pending = 1;
+
+	//the header and body go out as two spans of one gathered write instead of being joined
+	request_spans[0] = writeSpan{ request.data(), request.size() };
+	request_spans[1] = writeSpan{ body, body_length };
 
-	request += body;
 	current_status = status::SEND_REQUEST;
 }
 
-void http::httpClient::patch(httpResponse& response, const dictionary& parameters, const dictionary& headers, const std::string& path, const std::string& body)
+void http::httpClient::pipeline(const dictionary& parameters, const dictionary& headers, const std::string& path)
 {
-	patch(parameters, headers, path, body);
+	//requests queued since the last response keep being appended until recvResponse starts writing them
+	if (!(pipelining && current_status == status::SEND_REQUEST))
+	{
+		checkIdle();
+
+		request.clear();
+
+		close_requested = false;
+		pipelining = true;
+	}
+
+	if (close_requested) throw std::runtime_error("Only the last pipelined request can ask the server to close the connection.");
 
-	do recvResponse(response);
-	while (current_status != status::RECEIVED_RESPONSE && current_status != status::TIMED_OUT);
+	constructRequest(parameters, headers, host, path, "GET", pipelined_request);
+	acceptEncoding(headers, pipelined_request);
+
+	request.append(pipelined_request);
+
+	close_requested = requestsClose(headers);
+	++responses_pending;
+
+	//every queued request goes out in one write
+	request_spans[0] = writeSpan{ request.data(), request.size() };
+	request_spans[1] = writeSpan{ nullptr, 0 };
+
+	current_status = status::SEND_REQUEST;
 }
 
-void http::httpClient::patch(const dictionary& parameters, const dictionary& headers, const std::string& path, const std::string& body)
+void http::httpClient::recvPipeline(std::vector<httpResponse>& responses)
 {
-	if (current_status != status::RECEIVED_RESPONSE && current_status != status::TIMED_OUT) throw std::runtime_error("Cannot make another http request while receiving a response.");
+	responses.resize(responses_pending);
 
-	request.clear();
+	for (httpResponse& response : responses)
+	{
+		awaitResponse(response);
 
-	constructRequest(parameters, headers, host, path, "PATCH", request);
+		if (current_status == status::TIMED_OUT) throw exceptions::exception("Http request timed out.");
+	}
+}
 
-	request += body;
-	current_status = status::SEND_REQUEST;
+void http::httpClient::get(httpResponse& response, const dictionary& parameters, const dictionary& headers, const std::string& path)
+{
+	get(parameters, headers, path);
+
+	awaitResponse(response);
+}
+
+void http::httpClient::get(const dictionary& parameters, const dictionary& headers, const std::string& path)
+{
+	prepareRequest(parameters, headers, path, "GET", nullptr, 0);
+}
+
+void http::httpClient::post(httpResponse& response, const dictionary& parameters, const dictionary& headers, const std::string& path, const std::string& body)
+{
+	prepareRequest(parameters, headers, path, "POST", body.data(), body.size()); //body outlives the request so it is sent from the caller's memory
+
+	awaitResponse(response);
+}
+
+void http::httpClient::post(const dictionary& parameters, const dictionary& headers, const std::string& path, const std::string& body)
+{
+	request_body.assign(body); //the caller's body may not outlive an asynchronous request
+
+	prepareRequest(parameters, headers, path, "POST", request_body.data(), request_body.size());
+}
+
+void http::httpClient::patch(httpResponse& response, const dictionary& parameters, const dictionary& headers, const std::string& path, const std::string& body)
+{
+	prepareRequest(parameters, headers, path, "PATCH", body.data(), body.size()); //body outlives the request so it is sent from the caller's memory
+
+	awaitResponse(response);
+}
+
+void http::httpClient::patch(const dictionary& parameters, const dictionary& headers, const std::string& path, const std::string& body)
+{
+	request_body.assign(body); //the caller's body may not outlive an asynchronous request
+
+	prepareRequest(parameters, headers, path, "PATCH", request_body.data(), request_body.size());
 }
 
 void http::httpClient::del(httpResponse& response, const dictionary& parameters, const dictionary& headers, const std::string& path)
 {
 	del(parameters, headers, path);
 
-	do recvResponse(response);
-	while (current_status != status::RECEIVED_RESPONSE && current_status != status::TIMED_OUT);
+	awaitResponse(response);
 }
 
 void http::httpClient::del(const dictionary& parameters, const dictionary& headers, const std::string& path)
 {
-	if (current_status != status::RECEIVED_RESPONSE && current_status != status::TIMED_OUT) throw std::runtime_error("Cannot make another http request while receiving a response.");
+	prepareRequest(parameters, headers, path, "DELETE", nullptr, 0);
+}
 
-	request.clear();
+void http::httpClient::awaitResponse(httpResponse& response)
+{
+	while (true)
+	{
+		uint64_t empty_reads = ssl_socket.get_stats().want_read.get();
 
-	constructRequest(parameters, headers, host, path, "DELETE", request);
+		if (recvResponse(response) == status::RECEIVED_RESPONSE || current_status == status::TIMED_OUT) return;
 
-	current_status = status::SEND_REQUEST;
+		//only wait when the step tried to read and found nothing - buffered chunks are parsed straight away
+		if (ssl_socket.get_stats().want_read.get() != empty_reads) ssl_socket.idle();
+	}
+}
+
+const socketStats& http::httpClient::get_stats() const noexcept
+{
+	return ssl_socket.get_stats();
 }
 
 status http::httpClient::recvResponse(httpResponse& response)
 {
+	status previous_status = current_status;
+
 	switch (current_status)
 	{
 		case status::SEND_REQUEST:
 		{
-			bytes = ssl_socket.write(request);
+			request_start_ns = steadyNanoseconds();
+			bytes = ssl_socket.write(request_spans, 2, 0);
 
-			if (bytes >= request.size()) current_status = status::RECEIVE_HEADER;
+			if (bytes >= request_spans[0].length + request_spans[1].length) current_status = status::RECEIVE_HEADER;
 			else current_status = status::SENDING_REQUEST;
 
 			break;
 		}
 		case status::SENDING_REQUEST:
 		{
-			bytes += ssl_socket.write(request.substr(bytes));
+			bytes += ssl_socket.write(request_spans, 2, bytes); //resume from the number of bytes already written
 
-			if (bytes >= request.size()) current_status = status::RECEIVE_HEADER;
+			if (bytes >= request_spans[0].length + request_spans[1].length) current_status = status::RECEIVE_HEADER;
 
 			break;
 		}
@@ -284,10 +783,9 @@ status http::httpClient::recvResponse(httpResponse& response)
 		{
 			response.clear();
 
-			sec_since_epoch = time(nullptr);
-			index = 0;
+			body_received = 0;
 
-			segment = "Status Code Info: ";
+			sec_since_epoch = time(nullptr);
 
 			current_status = status::RECEIVING_HEADER;
 
@@ -297,42 +795,36 @@ status http::httpClient::recvResponse(httpResponse& response)
 		{
 			if (time(nullptr) - sec_since_epoch >= timeout) current_status = status::TIMED_OUT;
 
-			bytes = ssl_socket.read(buffer, HTTP_UTILS_BUFFER_SIZE);
+			//a pipelined response may have arrived with the end of the previous one
+			if (!unread.empty())
+			{
+				body_prefix.swap(unread);
+				unread.clear();
+
+				bytes = static_cast<int>(body_prefix.size());
+			}
+			else bytes = ssl_socket.read(buffer, HTTP_UTILS_BUFFER_SIZE);
 
 			if (bytes)
 			{
-				segment.append(&buffer[0], bytes); //segment += std::string(&buffer[0], bytes);
-				index = segment.find("\r\n\r\n");
+				bool received_header = appendHeader(response, body_prefix.empty() ? buffer : body_prefix.data(), bytes);
+
+				body_prefix.clear();
 
-				if (index != std::string::npos)
+				if (received_header)
 				{
-					response.message = segment.substr(index + 4);
-					segment = segment.substr(0, index);
-					index = segment.find("\r\n");
+					//HTTP/1.1 connections stay open unless the server says otherwise - only the last pipelined request may have asked to close
+					keep_alive = !(close_requested && responses_pending == 1) && !response.close;
 
-					while (index != std::string::npos)
+					if (response.chunked) current_status = status::RECEIVE_CHUNKED_BODY;
+					else if (response.content_length >= 0) current_status = status::RECEIVE_BODY;
+					else if (response.status_code == 204)
 					{
-						field = segment.substr(0, index);
-						segment = segment.substr(index + 2);
-						index = field.find(": ");
-
-						response.fields[field.substr(0, index)] = field.substr(index + 2);
+						unread.swap(response.message); //anything after the header belongs to the next response
 
-						index = segment.find("\r\n");
+						current_status = status::RECEIVED_RESPONSE;
 					}
 
-					segment = response.fields["Status Code Info"].substr(9);
-					index = segment.find(" ");
-
-					response.status_code = std::stoi(segment.substr(0, index));
-					response.status_message = segment.substr(index + 1);
-
-					response.fields.erase("Status Code Info");
-
-					if (response.fields.find("Transfer-Encoding") != response.fields.end()) current_status = status::RECEIVE_CHUNKED_BODY;
-					else if (response.fields.find("Content-Length") != response.fields.end()) current_status = status::RECEIVE_BODY;
-					else if (response.status_code == 204) current_status = status::RECEIVED_RESPONSE;
-
 					/*
 					Every response from a well - behaved http server MUST include either a "Transfer-Encoding" or "Content-Length" header ...
 					... unless the status code from the response is 204 - which indicates a successful delete request.
@@ -350,87 +842,98 @@ status http::httpClient::recvResponse(httpResponse& response)
 		{
 			sec_since_epoch = time(nullptr);
 
-			last_segment = "";
-			segment = response.message;
+			chunked_decoder.reset();
+
+			//the body bytes read along with the header are decoded into the emptied message
+			body_prefix.swap(response.message);
+			response.message.clear();
+
+			if (response.encoded) resetInflater(response);
+
+			body_received = 0;
 
-			response.message.clear(); //write the final response here
+			size_t consumed = decodeChunks(body_prefix.data(), body_prefix.size(), response);
+
+			if (consumed < body_prefix.size()) unread.assign(body_prefix, consumed);
+
+			body_prefix.clear();
 
 			current_status = status::RECEIVING_CHUNK_SIZE;
 
 			break;
 		}
 		case status::RECEIVING_CHUNK_SIZE: //receive chunk sizes
+		case status::RECEIVING_CHUNK: //receive chunks
 		{
-			if (time(nullptr) - sec_since_epoch >= timeout) current_status = status::TIMED_OUT;
-
-			full_segment = last_segment + segment;
-			index = full_segment.find("\r\n");
-
-			if (index != std::string::npos)
+			if (!chunked_decoder.done())
 			{
-				if (full_segment.substr(0, index) == "0") current_status = status::RECEIVED_RESPONSE; //a chunk size of 0 indicates the end of the message
-				else
+				if (time(nullptr) - sec_since_epoch >= timeout)
 				{
-					//do something with the chunk sizes here if needed
-					segment = full_segment.substr(index + 2);
-					last_segment.clear();
+					current_status = status::TIMED_OUT;
 
-					current_status = status::RECEIVING_CHUNK;
+					break;
 				}
-			}
-			else
-			{
+
 				bytes = ssl_socket.read(buffer, HTTP_UTILS_BUFFER_SIZE);
 
 				if (bytes)
 				{
-					//can log chunk sizes if needed - std::string chunk_size = last_segment;
+					size_t consumed = decodeChunks(buffer, bytes, response);
+
+					if (consumed < static_cast<size_t>(bytes)) unread.assign(buffer + consumed, bytes - consumed);
 
-					last_segment = segment;
-					segment.assign(&buffer[0], bytes); //segment = std::string(&buffer[0], bytes);
 					sec_since_epoch = time(nullptr);
 				}
 			}
 
-			break;
-		}
-		case status::RECEIVING_CHUNK: //receive chunks
-		{
-			if (time(nullptr) - sec_since_epoch >= timeout) current_status = status::TIMED_OUT;
-
-			full_segment = last_segment + segment;
-			index = full_segment.find("\r\n");
-
-			if (index != std::string::npos)
-			{
-				response.message.append(full_segment.substr(0, index)); //response.message += full_segment.substr(0, index);
-				segment = full_segment.substr(index + 2);
-				last_segment.clear();
-
-				current_status = status::RECEIVING_CHUNK_SIZE;
-			}
-			else
+			if (chunked_decoder.done())
 			{
-				bytes = ssl_socket.read(buffer, HTTP_UTILS_BUFFER_SIZE);
-
-				if (bytes)
+				if (!chunked_decoder.trailers().empty())
 				{
-					response.message.append(last_segment); //response.message += last_segment;
+					//trailer fields are added to the header so find sees them, but the body was already decoded under the header's typed fields
+					size_t trailer_start = response.header.size();
 
-					last_segment = segment;
-					segment.assign(&buffer[0], bytes); //segment = std::string(&buffer[0], bytes);
-					sec_since_epoch = time(nullptr);
+					response.header.append(chunked_decoder.trailers());
+					parseTrailer(response, trailer_start);
 				}
+
+				current_status = status::RECEIVED_RESPONSE;
 			}
+			else current_status = chunked_decoder.in_data() ? status::RECEIVING_CHUNK : status::RECEIVING_CHUNK_SIZE;
 
 			break;
 		}
 		case status::RECEIVE_BODY:
 		{
-			max_message_length = std::stoll(response.fields["Content-Length"]);
+			max_message_length = static_cast<size_t>(response.content_length);
 			sec_since_epoch = time(nullptr);
 
-			if (response.message.size() >= max_message_length) current_status = status::RECEIVED_RESPONSE;
+			if (response.encoded)
+			{
+				//the body bytes read along with the header are inflated into the emptied message
+				encoded_body.swap(response.message);
+				response.message.clear();
+
+				body_received = std::min(encoded_body.size(), max_message_length);
+
+				if (encoded_body.size() > body_received) unread.assign(encoded_body, body_received); //the start of a pipelined response
+
+				resetInflater(response);
+				inflateBody(encoded_body.data(), body_received, response);
+
+				current_status = body_received >= max_message_length ? status::RECEIVED_RESPONSE : status::RECEIVING_BODY;
+
+				break;
+			}
+
+			if (response.message.size() >= max_message_length)
+			{
+				if (response.message.size() > max_message_length) unread.assign(response.message, max_message_length); //the start of a pipelined response
+
+				response.message.resize(max_message_length);
+
+				current_status = status::RECEIVED_RESPONSE;
+			}
 			else current_status = status::RECEIVING_BODY;
 
 			break;
@@ -443,19 +946,141 @@ status http::httpClient::recvResponse(httpResponse& response)
 
 			if (bytes)
 			{
-				response.message.append(&buffer[0], bytes); //response.message += std::string(&buffer[0], bytes);
+				//only the bytes of this body are appended - the rest start a pipelined response
+				size_t remaining = max_message_length - (response.encoded ? body_received : response.message.size());
+				size_t body_bytes = std::min<size_t>(bytes, remaining);
+
+				if (response.encoded)
+				{
+					inflateBody(buffer, body_bytes, response);
 
-				if (response.message.size() >= max_message_length) current_status = status::RECEIVED_RESPONSE;
+					body_received += body_bytes;
+				}
+				else response.message.append(&buffer[0], body_bytes);
+
+				if (body_bytes < static_cast<size_t>(bytes)) unread.assign(buffer + body_bytes, bytes - body_bytes);
+				if (body_bytes == remaining) current_status = status::RECEIVED_RESPONSE;
 
 				sec_since_epoch = time(nullptr);
 			}
 
 			break;
 		}
-		case status::RECEIVED_RESPONSE: break;
+		case status::RECEIVED_RESPONSE:
+		{
+			//the next pipelined response is received into the response passed to this call
+			if (responses_pending)
+			{
+				if (!keep_alive) throw exceptions::exception("The server closed the connection with " + std::to_string(responses_pending) + " pipelined requests unanswered.");
+
+				current_status = status::RECEIVE_HEADER;
+			}
+
+			break;
+		}
 		case status::TIMED_OUT: break;
 		default: throw std::runtime_error("Unknown http get status.");
 	}
 
+	if (current_status == status::RECEIVED_RESPONSE && previous_status != status::RECEIVED_RESPONSE)
+	{
+		--responses_pending;
+
+		if (response.encoded && body_received && !inflater.finished())
+		{
+			//the response is accounted for but the connection can't be trusted for the next one
+			keep_alive = false;
+			responses_pending = 0;
+			unread.clear();
+
+			throw exceptions::exception("Compressed http body ended before the end of its compressed stream.");
+		}
+
+		ssl_socket.get_stats().request_to_response.record(steadyNanoseconds() - request_start_ns);
+	}
+
 	return current_status;
-}
\ No newline at end of file
+}
+http::httpClientPool::httpClientPool(const httpClientPool& other_pool) : ssl_context_wrapper(other_pool.ssl_context_wrapper)
+{
+	throw std::runtime_error("httpClientPool type doesn't support copy construction.");
+}
+
+http::httpClientPool::httpClientPool(const SSLContextWrapper& SSL_context_wrapper, const time_t Timeout, const time_t Max_idle, const size_t Max_idle_per_host)
+	: ssl_context_wrapper(const_cast<SSLContextWrapper&>(SSL_context_wrapper)), timeout(Timeout), max_idle(Max_idle), max_idle_per_host(Max_idle_per_host) {}
+
+http::httpClientPool::~httpClientPool()
+{
+	clear();
+}
+
+httpClientPool& httpClientPool::operator=(const httpClientPool& other_pool)
+{
+	throw std::runtime_error("httpClientPool type doesn't support re-assignment.");
+}
+
+std::unique_ptr<httpClient> http::httpClientPool::acquire(const std::string& host)
+{
+	std::vector<idleClient> retired; //closed after the lock is released since shutting down a connection can block
+
+	{
+		std::lock_guard<std::mutex> guard(pool_mutex);
+
+		std::vector<idleClient>& clients = idle_clients[host];
+		time_t now = time(nullptr);
+
+		//the most recently used connection is the most likely to still be open
+		while (!clients.empty())
+		{
+			idleClient idle_client = std::move(clients.back());
+
+			clients.pop_back();
+
+			if (now - idle_client.idle_since < max_idle && idle_client.client->is_alive()) return std::move(idle_client.client);
+
+			retired.push_back(std::move(idle_client));
+		}
+	}
+
+	std::unique_ptr<httpClient> client = std::make_unique<httpClient>(ssl_context_wrapper, host, true, timeout);
+
+	client->reConnect();
+
+	return client;
+}
+
+void http::httpClientPool::release(std::unique_ptr<httpClient> client)
+{
+	if (!client || !client->reusable()) return; //the connection is closed when client goes out of scope
+
+	std::lock_guard<std::mutex> guard(pool_mutex);
+
+	std::vector<idleClient>& clients = idle_clients[client->get_host()];
+
+	if (clients.size() < max_idle_per_host) clients.push_back(idleClient{ std::move(client), time(nullptr) });
+}
+
+void http::httpClientPool::clear()
+{
+	std::unordered_map<std::string, std::vector<idleClient>> retired;
+
+	{
+		std::lock_guard<std::mutex> guard(pool_mutex);
+
+		retired.swap(idle_clients);
+	}
+}
+
+size_t http::httpClientPool::idle_count(const std::string& host)
+{
+	std::lock_guard<std::mutex> guard(pool_mutex);
+
+	auto iterator = idle_clients.find(host);
+
+	return iterator == idle_clients.end() ? 0 : iterator->second.size();
+}
+
+time_t http::httpClientPool::get_timeout() const noexcept
+{
+	return timeout;
+}
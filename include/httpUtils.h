@@ -6,12 +6,21 @@
 #define HTTP_UTILS_H
 
 #define HTTP_UTILS_BUFFER_SIZE 4096
+#define HTTP_UTILS_MAX_FIELDS 64 //header fields kept per response
+#define HTTP_UTILS_MAX_HEADER_SIZE 65536 //a response header larger than this is rejected instead of buffered
 
 #include "exceptUtils.h"
+#include "arrayUtils.h"
+#include "zlibUtils.h"
 
 #include <ctime>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <stdexcept>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include "socketUtils.h"
 
@@ -41,26 +50,105 @@ namespace http
 		TIMED_OUT             //no data was received within the timeout limit
 	};
 
+	//a header field as offsets into httpResponse::header so a copied response still points at its own bytes
+	struct httpField
+	{
+		uint32_t name_start;
+		uint32_t name_length;
+		uint32_t value_start;
+		uint32_t value_length;
+	};
+
+	/*
+	the raw header is kept in header and each field is recorded as offsets into it - nothing is copied per field ...
+	... so a response object that is reused does not allocate while parsing a typical header
+	the fields that drive the client (and rate limits) are also parsed into typed members as the header is scanned
+	field names are matched case insensitively
+	*/
 	struct httpResponse
 	{
 		int status_code = 0;
 
-		std::string status_message;
 		std::string message;
+		std::string header; //status line and header fields, each line ending in \r\n
+
+		array<httpField, HTTP_UTILS_MAX_FIELDS> fields;
+
+		int64_t content_length = -1; //-1 if there was no Content-Length field
+		bool chunked = false; //Transfer-Encoding ends in chunked
+		bool close = false; //Connection: close
+		bool encoded = false; //Content-Encoding is gzip or deflate - the client inflates the body into message as it arrives
+
+		//X-RateLimit-* or RateLimit-* and Retry-After fields - -1 if the server did not send them
+		int64_t rate_limit = -1;
+		int64_t rate_limit_remaining = -1;
+		int64_t rate_limit_reset = -1;
+		int64_t retry_after = -1;
 
-		dictionary fields;
+		std::string_view status_message() const noexcept;
+		std::string_view field_name(const size_t) const;
+		std::string_view field_value(const size_t) const;
+
+		std::string_view find(const std::string_view) const noexcept; //value of the first field with the name - empty if there is none
+		bool has(const std::string_view) const noexcept;
 
 		void clear();
+
+		uint32_t status_start = 0;
+		uint32_t status_length = 0;
 	};
 
 	void constructRequest(const dictionary&, const dictionary&, const std::string&, const std::string&, const std::string&, std::string&); //construct the http request
 	void parseResponseHeader(SSLSocket&, time_t, httpResponse&); //parse the response header from a request
 
+	/*
+	parse the header already stored in response.header (status line and fields with their line endings, without the blank line)
+	fills the status, the field offsets and the typed fields in one pass
+	*/
+	void parseHeader(httpResponse&);
+
+	/*
+	record the trailer fields appended to response.header from the given offset
+	they are found by find and has like header fields, but never change the typed fields the body was already decoded under
+	*/
+	void parseTrailer(httpResponse&, const size_t);
+
+	/*
+	decodes a chunked body as it arrives - bytes can be fed in any split
+	the hex size of each chunk is parsed (extensions are skipped) and exactly that many bytes are appended to the destination ...
+	... so chunk data is copied once and never searched, and may contain line endings
+	trailer fields are collected into trailers - decode stops after the blank line that ends the body and returns the bytes it used
+	*/
+	class chunkedDecoder
+	{
+	public:
+		void reset() noexcept;
+
+		size_t decode(const char*, const size_t, std::string&); //data, length, destination - returns the bytes consumed
+
+		inline bool done() const noexcept { return phase == chunkPhase::DONE; }
+		inline bool in_data() const noexcept { return phase == chunkPhase::DATA; } //inside the data of a chunk rather than a size line or the trailer
+
+		inline const std::string& trailers() const noexcept { return trailer_fields; } //trailer field lines, each ending in \r\n
+
+	private:
+		enum class chunkPhase { SIZE, EXTENSION, SIZE_LF, DATA, DATA_CR, DATA_LF, TRAILER_START, TRAILER, END_LF, DONE };
+
+		chunkPhase phase = chunkPhase::SIZE;
+
+		uint64_t remaining = 0; //size of the chunk while parsing the size line, then the bytes of it still to come
+		size_t digits = 0;
+
+		std::string trailer_fields;
+	};
+
+	class httpClientPool;
+
 	/*
 	make sure that ...
 		1) the response object is empty before making any http request and
 		2) the "Connection" header is set to "close" for individual http requests
-			If you want to initialte a keep-alive connection, use the httpClient
+			If you want to initialte a keep-alive connection, use the httpClient or the overloads that take an httpClientPool
 	if reusing the response object call httpResponse.clear before performing another request
 	*/
 
@@ -69,11 +157,22 @@ namespace http
 	void patch(const SSLContextWrapper&, httpResponse&, const dictionary&, const dictionary&, const std::string&, const std::string&, const std::string&, const time_t);
 	void del(const SSLContextWrapper&, httpResponse&, const dictionary&, const dictionary&, const std::string&, const std::string&, const time_t); //delete request
 
+	/*
+	the same requests over a warm keep-alive connection borrowed from a pool - set "Connection" to "keep-alive" (or leave it out) for these
+	get and del are retried once on a fresh connection if a pooled connection fails (closed, reset or a tls error) before any of the response arrives
+	*/
+
+	void get(httpClientPool&, httpResponse&, const dictionary&, const dictionary&, const std::string&, const std::string&);
+	void post(httpClientPool&, httpResponse&, const dictionary&, const dictionary&, const std::string&, const std::string&, const std::string&);
+	void patch(httpClientPool&, httpResponse&, const dictionary&, const dictionary&, const std::string&, const std::string&, const std::string&);
+	void del(httpClientPool&, httpResponse&, const dictionary&, const dictionary&, const std::string&, const std::string&); //delete request
+
 	class httpClient
 	{
 	public:
 		httpClient(const httpClient&);
-		httpClient(const SSLContextWrapper&, const std::string, const bool, const time_t);
+		httpClient(const SSLContextWrapper&, const std::string, const bool, const time_t); //tls on port 443
+		httpClient(const SSLContextWrapper&, const std::string, const std::string, const socketTransport, const bool, const time_t); //host, port, transport, blocking, timeout
 		~httpClient();
 
 		httpClient& operator=(const httpClient&);
@@ -84,39 +183,127 @@ namespace http
 		void get(const dictionary&, const dictionary&, const std::string&); //for asynchronous get requests - prepares the request to be sent
 
 		void post(httpResponse&, const dictionary&, const dictionary&, const std::string&, const std::string&); //for individual post requests
-		void post(const dictionary&, const dictionary&, const std::string&, const std::string&); //for asynchronous post requests - prepares the request to be sent
+		void post(const dictionary&, const dictionary&, const std::string&, const std::string&); //for asynchronous post requests - prepares the request to be sent (copies the body)
 
 		void patch(httpResponse&, const dictionary&, const dictionary&, const std::string&, const std::string&); //for individual patch requests
-		void patch(const dictionary&, const dictionary&, const std::string&, const std::string&); //for asynchronous patch requests - prepares the request to be sent
+		void patch(const dictionary&, const dictionary&, const std::string&, const std::string&); //for asynchronous patch requests - prepares the request to be sent (copies the body)
 
 		void del(httpResponse&, const dictionary&, const dictionary&, const std::string&); //for individual delete requests
 		void del(const dictionary&, const dictionary&, const std::string&); //for asynchronous delete requests - prepares the request to be sent
 
 		status recvResponse(httpResponse&); //receive data for a asynchronous http request - use after request is prepared
 
+		/*
+		pipelining - queue several get requests, which are written back to back by the next recvResponse, and receive the responses in order
+		call recvResponse with the first response until it returns RECEIVED_RESPONSE, then with the next response, and so on ...
+		... or call recvPipeline to receive them all - a queued request can only ask to close the connection if it is the last one
+		if a pipelined response times out, call reConnect before the next request - the late responses would otherwise be read as its response
+		*/
+		void pipeline(const dictionary&, const dictionary&, const std::string&);
+		void recvPipeline(std::vector<httpResponse>&); //send the queued requests and receive one response per request (resizes the vector)
+		inline size_t pending() const noexcept { return responses_pending; } //responses still expected for the requests sent or queued
+
+		const socketStats& get_stats() const noexcept; //safe to read from a monitoring thread
+		const std::string& get_host() const noexcept;
+
+		bool reusable() const noexcept; //true if the last response completed and the server did not ask to close the connection
+		bool is_alive(); //true if the idle connection is still open - does not block
+
+		void setWaitStrategy(const waitStrategy&); //how the individual requests wait for a non-blocking response (see SSLSocket::setWaitStrategy)
+
+		/*
+		on by default - requests advertise "Accept-Encoding: gzip, deflate" unless the caller set Accept-Encoding and compressed bodies are inflated as they arrive
+		trades a little cpu for far fewer bytes on large json responses - turn it off for small latency sensitive requests
+		*/
+		void setCompression(const bool);
+
 	private:
+		void prepareRequest(const dictionary&, const dictionary&, const std::string&, const char*, const char*, const size_t); //method, body, body length
+		void checkIdle(); //throw unless a new request can be written on the connection
+		void awaitResponse(httpResponse&); //drive recvResponse until the response is received or times out, idling between empty reads
+		void acceptEncoding(const dictionary&, std::string&); //add Accept-Encoding to a constructed request if compression is on
+		size_t decodeChunks(const char*, const size_t, httpResponse&); //decode chunks into the message (inflating an encoded body) - returns the bytes consumed
+		void resetInflater(const httpResponse&); //prepare the inflater for the encoded body of a response whose header was parsed
+		void inflateBody(const char*, const size_t, httpResponse&); //inflate the next piece of an encoded body into the message
+
 		SSLSocket ssl_socket;
 
 		std::string request;
+		std::string request_body; //storage for the bodies of asynchronous requests
 		std::string host;
 
+		writeSpan request_spans[2]; //request line and headers, then the body
+
 		time_t timeout;
 
 		char buffer[HTTP_UTILS_BUFFER_SIZE];
 		int bytes;
 
 		time_t sec_since_epoch;
-		size_t index;
-
-		std::string field;
-		std::string segment;
+		int64_t request_start_ns; //when the current request started sending
 
 		size_t max_message_length;
 
-		std::string full_segment;
-		std::string last_segment;
+		chunkedDecoder chunked_decoder;
+		std::string body_prefix; //body bytes that arrived with the header - decoded before the next read
+		std::string unread; //bytes read past the end of a response - the start of the next pipelined response
+		std::string pipelined_request; //reused while appending a request to the pipeline
+
+		inflateStream inflater; //reset for every encoded response - keeps its zlib state and window allocated
+		std::string encoded_body; //decoded chunks of an encoded body waiting to be inflated
+		size_t body_received; //body bytes received as sent - the compressed size for an encoded body
+		bool sniff_deflate; //the first byte of a deflate body decides between zlib data and the raw deflate some servers send
+		bool compression;
 
 		status current_status;
+
+		bool keep_alive; //false if the server will close the connection after the current response
+		bool close_requested; //true if the current request asked the server to close the connection
+
+		bool pipelining; //true while the requests waiting to be sent were queued with pipeline
+		size_t responses_pending; //responses not yet received for the requests that were sent or queued
+	};
+
+	/*
+	a pool of warm keep-alive connections keyed by host
+	acquire hands out an idle connection to the host if a live one exists and connects a new one otherwise
+	release returns a connection to the pool if it can be reused and closes it if not
+	idle connections are closed once they have been idle for max_idle seconds - set this below the server's keep-alive timeout
+	safe to share between threads - each connection is only ever used by the thread that acquired it
+	*/
+
+	class httpClientPool
+	{
+	public:
+		httpClientPool(const httpClientPool&); //I have this to make sure that I am not using the copy constructor
+		httpClientPool(const SSLContextWrapper&, const time_t, const time_t, const size_t); //timeout, max_idle, max idle connections per host
+		~httpClientPool();
+
+		httpClientPool& operator=(const httpClientPool&); //I have this to make sure that I am not using item assignment
+
+		std::unique_ptr<httpClient> acquire(const std::string&); //borrow a connected client for a host
+		void release(std::unique_ptr<httpClient>); //return a client to the pool
+
+		void clear(); //close every idle connection
+		size_t idle_count(const std::string&); //number of idle connections to a host
+
+		time_t get_timeout() const noexcept;
+
+	private:
+		struct idleClient
+		{
+			std::unique_ptr<httpClient> client;
+			time_t idle_since;
+		};
+
+		SSLContextWrapper& ssl_context_wrapper;
+
+		time_t timeout;
+		time_t max_idle;
+		size_t max_idle_per_host;
+
+		std::unordered_map<std::string, std::vector<idleClient>> idle_clients;
+		std::mutex pool_mutex;
 	};
 }
 #endif
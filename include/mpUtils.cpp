@@ -0,0 +1,237 @@
+#include "mpUtils.h"
+
+#include <cstring>
+
+double msgpackValue::as_double() const
+{
+	switch (type)
+	{
+	case msgpackType::FLOAT: return number;
+	case msgpackType::INTEGER: return static_cast<double>(integer);
+	case msgpackType::UNSIGNED: return static_cast<double>(unsigned_integer);
+	default: throw std::runtime_error("MessagePack value is not a number.");
+	}
+}
+
+int64_t msgpackValue::as_int() const
+{
+	switch (type)
+	{
+	case msgpackType::INTEGER: return integer;
+	case msgpackType::UNSIGNED: return static_cast<int64_t>(unsigned_integer);
+	case msgpackType::FLOAT: return static_cast<int64_t>(number);
+	case msgpackType::TIMESTAMP: return timestamp_ns;
+	default: throw std::runtime_error("MessagePack value is not an integer.");
+	}
+}
+
+msgpackReader::msgpackReader(const char* data, const size_t length)
+	: c(reinterpret_cast<const unsigned char*>(data)), end(reinterpret_cast<const unsigned char*>(data) + length) {}
+
+msgpackReader::msgpackReader(const std::string_view data) : msgpackReader(data.data(), data.size()) {}
+
+void msgpackReader::need(const size_t length) const
+{
+	if (static_cast<size_t>(end - c) < length) throw std::runtime_error("Truncated MessagePack value.");
+}
+
+uint64_t msgpackReader::readBigEndian(const size_t length)
+{
+	need(length);
+
+	uint64_t value = 0;
+
+	for (size_t index = 0; index < length; ++index) value = value << 8 | c[index];
+
+	c += length;
+
+	return value;
+}
+
+msgpackValue msgpackReader::descend()
+{
+	need(1);
+
+	msgpackValue value;
+	unsigned char format = *c++;
+
+	size_t length = 0; //length of string, binary, and extension data
+
+	if (format <= 0x7f) //positive fixint
+	{
+		value.type = msgpackType::UNSIGNED;
+		value.unsigned_integer = format;
+
+		return value;
+	}
+
+	if (format >= 0xe0) //negative fixint
+	{
+		value.type = msgpackType::INTEGER;
+		value.integer = static_cast<int8_t>(format);
+
+		return value;
+	}
+
+	if (format <= 0x8f || (format >= 0x90 && format <= 0x9f))
+	{
+		value.type = format <= 0x8f ? msgpackType::MAP : msgpackType::ARRAY;
+		value.count = format & 0x0f;
+
+		return value;
+	}
+
+	if (format <= 0xbf) //fixstr
+	{
+		value.type = msgpackType::STRING;
+		length = format & 0x1f;
+	}
+	else switch (format)
+	{
+	case 0xc0: value.type = msgpackType::NIL; return value;
+	case 0xc2: value.type = msgpackType::BOOLEAN; value.boolean = false; return value;
+	case 0xc3: value.type = msgpackType::BOOLEAN; value.boolean = true; return value;
+
+	case 0xc4: case 0xc5: case 0xc6: //bin 8, 16, 32
+		value.type = msgpackType::BINARY;
+		length = static_cast<size_t>(readBigEndian(size_t(1) << (format - 0xc4)));
+		break;
+
+	case 0xc7: case 0xc8: case 0xc9: //ext 8, 16, 32
+		value.type = msgpackType::EXTENSION;
+		length = static_cast<size_t>(readBigEndian(size_t(1) << (format - 0xc7)));
+		value.extension_type = static_cast<int8_t>(readBigEndian(1));
+		break;
+
+	case 0xca:
+	{
+		uint32_t bits = static_cast<uint32_t>(readBigEndian(4));
+		float number;
+
+		memcpy(&number, &bits, 4);
+
+		value.type = msgpackType::FLOAT;
+		value.number = number;
+
+		return value;
+	}
+	case 0xcb:
+	{
+		uint64_t bits = readBigEndian(8);
+
+		value.type = msgpackType::FLOAT;
+		memcpy(&value.number, &bits, 8);
+
+		return value;
+	}
+
+	case 0xcc: case 0xcd: case 0xce: case 0xcf: //uint 8, 16, 32, 64
+		value.type = msgpackType::UNSIGNED;
+		value.unsigned_integer = readBigEndian(size_t(1) << (format - 0xcc));
+		return value;
+
+	case 0xd0: case 0xd1: case 0xd2: case 0xd3: //int 8, 16, 32, 64 - sign extend from the encoded width
+	{
+		size_t width = size_t(1) << (format - 0xd0);
+		uint64_t bits = readBigEndian(width);
+		size_t shift = 64 - 8 * width;
+
+		value.type = msgpackType::INTEGER;
+		value.integer = static_cast<int64_t>(bits << shift) >> shift;
+
+		return value;
+	}
+
+	case 0xd4: case 0xd5: case 0xd6: case 0xd7: case 0xd8: //fixext 1, 2, 4, 8, 16
+		value.type = msgpackType::EXTENSION;
+		length = size_t(1) << (format - 0xd4);
+		value.extension_type = static_cast<int8_t>(readBigEndian(1));
+		break;
+
+	case 0xd9: case 0xda: case 0xdb: //str 8, 16, 32
+		value.type = msgpackType::STRING;
+		length = static_cast<size_t>(readBigEndian(size_t(1) << (format - 0xd9)));
+		break;
+
+	case 0xdc: case 0xdd: //array 16, 32
+		value.type = msgpackType::ARRAY;
+		value.count = static_cast<uint32_t>(readBigEndian(format == 0xdc ? 2 : 4));
+		return value;
+
+	case 0xde: case 0xdf: //map 16, 32
+		value.type = msgpackType::MAP;
+		value.count = static_cast<uint32_t>(readBigEndian(format == 0xde ? 2 : 4));
+		return value;
+
+	default: throw std::runtime_error("Invalid MessagePack format byte.");
+	}
+
+	need(length);
+
+	value.bytes = std::string_view(reinterpret_cast<const char*>(c), length);
+	c += length;
+
+	//the timestamp extension (-1) is 32 bit seconds, 30 bit nanoseconds and 34 bit seconds, or 32 bit nanoseconds and 64 bit seconds
+	if (value.type == msgpackType::EXTENSION && value.extension_type == -1)
+	{
+		const unsigned char* data = reinterpret_cast<const unsigned char*>(value.bytes.data());
+
+		uint64_t seconds = 0;
+		uint64_t nanoseconds = 0;
+
+		if (length == 4) for (size_t index = 0; index < 4; ++index) seconds = seconds << 8 | data[index];
+		else if (length == 8)
+		{
+			uint64_t bits = 0;
+
+			for (size_t index = 0; index < 8; ++index) bits = bits << 8 | data[index];
+
+			nanoseconds = bits >> 34;
+			seconds = bits & 0x3ffffffffULL;
+		}
+		else if (length == 12)
+		{
+			for (size_t index = 0; index < 4; ++index) nanoseconds = nanoseconds << 8 | data[index];
+			for (size_t index = 4; index < 12; ++index) seconds = seconds << 8 | data[index];
+		}
+		else return value; //not a valid timestamp - leave it as a plain extension
+
+		value.type = msgpackType::TIMESTAMP;
+		value.timestamp_ns = static_cast<int64_t>(seconds) * 1000000000LL + static_cast<int64_t>(nanoseconds);
+	}
+
+	return value;
+}
+
+void msgpackReader::skip(const uint64_t count)
+{
+	uint64_t remaining = count;
+
+	while (remaining)
+	{
+		msgpackValue value = descend();
+
+		--remaining;
+
+		if (value.type == msgpackType::ARRAY) remaining += value.count;
+		else if (value.type == msgpackType::MAP) remaining += 2ULL * value.count;
+
+		if (remaining > static_cast<uint64_t>(end - c)) throw std::runtime_error("Truncated MessagePack value."); //every value takes at least one byte
+	}
+}
+
+msgpackValue msgpackReader::next()
+{
+	msgpackValue value = descend();
+
+	if (value.type == msgpackType::ARRAY || value.type == msgpackType::MAP)
+	{
+		const unsigned char* elements = c;
+
+		skip(value.type == msgpackType::MAP ? 2ULL * value.count : value.count);
+
+		value.bytes = std::string_view(reinterpret_cast<const char*>(elements), c - elements);
+	}
+
+	return value;
+}
@@ -0,0 +1,138 @@
+
+//messagepack decoding for binary data streams (alpaca streams send messagepack when the upgrade request asks for application/msgpack)
+
+#ifndef MP_UTILS_H
+#define MP_UTILS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+enum class msgpackType : uint8_t { NIL, BOOLEAN, INTEGER, UNSIGNED, FLOAT, STRING, BINARY, ARRAY, MAP, EXTENSION, TIMESTAMP };
+
+/*
+one decoded messagepack value - strings, binary data, and extension data point into the message (nothing is copied)
+arrays and maps hold their element count and bytes spans their encoded elements so they can be read with another msgpackReader
+*/
+
+struct msgpackValue
+{
+	msgpackType type = msgpackType::NIL;
+
+	union
+	{
+		bool boolean;
+		int64_t integer; //negative integers (and signed types holding positive values)
+		uint64_t unsigned_integer; //positive integers
+		double number; //float 32 and float 64
+		uint32_t count; //number of elements in an array or pairs in a map
+		int64_t timestamp_ns; //extension type -1 converted to nanoseconds since the epoch
+	};
+
+	int8_t extension_type = 0;
+
+	std::string_view bytes;
+
+	msgpackValue() : unsigned_integer(0) {}
+
+	double as_double() const; //any numeric type
+	int64_t as_int() const; //any integer type (floats are truncated)
+	inline std::string_view as_string() const noexcept { return bytes; }
+};
+
+/*
+reads one value at a time from a messagepack buffer
+nested arrays and maps are stepped over with a counter instead of recursion, so deep nesting cannot overflow the stack
+throws std::runtime_error when the buffer ends in the middle of a value or holds an unused format byte (0xc1)
+*/
+
+class msgpackReader
+{
+public:
+	msgpackReader(const char*, const size_t);
+	msgpackReader(const std::string_view);
+
+	inline bool done() const noexcept { return c >= end; }
+
+	msgpackValue next(); //read the next value - for arrays and maps this steps over all of their elements
+	msgpackValue descend(); //read the next value - for arrays and maps the reader moves to their first element instead (bytes is empty)
+	void skip(const uint64_t); //step over the given number of values
+
+private:
+	void need(const size_t) const;
+
+	uint64_t readBigEndian(const size_t); //assemble an unsigned integer from the next 1, 2, 4, or 8 bytes
+
+	const unsigned char* c;
+	const unsigned char* end;
+};
+
+/*
+a class for parsing messagepack arrays of maps (or a single map) - the messagepack counterpart of JSONArrayParser
+container - structure for storing or updating with the data in a map
+updateObject - the object we are updating with the information from the container
+containerUpdateFunc - update information in container with one key : value pair (the key and value point into the message)
+updateFunc - use the data in the container to do something to updateObject
+
+values are typed so the update function reads numbers and timestamps directly instead of converting them from strings
+*/
+
+template <typename container, typename updateObject, void (*containerUpdateFunc)(container&, const std::string_view, const msgpackValue&), void (*updateFunc)(const container&, updateObject&)>
+class MsgPackArrayParser
+{
+private:
+	container information; //contains information about the most recently parsed map
+
+	void parseMap(msgpackReader&, const uint32_t, updateObject&);
+
+public:
+	MsgPackArrayParser() {}
+	~MsgPackArrayParser() {}
+
+	//return a read-only reference to the information container
+	inline const container& get_info() const noexcept { return information; }
+
+	void parseMsgPackArray(const std::string_view, updateObject&);
+};
+
+template <typename container, typename updateObject, void (*containerUpdateFunc)(container&, const std::string_view, const msgpackValue&), void (*updateFunc)(const container&, updateObject&)>
+void MsgPackArrayParser<container, updateObject, containerUpdateFunc, updateFunc>::parseMap(msgpackReader& reader, const uint32_t count, updateObject& update_object)
+{
+	for (uint32_t index = 0; index < count; ++index)
+	{
+		msgpackValue key = reader.next();
+		msgpackValue value = reader.next();
+
+		if (key.type != msgpackType::STRING) throw std::runtime_error("MessagePack map keys must be strings.");
+
+		containerUpdateFunc(information, key.bytes, value);
+	}
+
+	updateFunc(information, update_object);
+}
+
+template <typename container, typename updateObject, void (*containerUpdateFunc)(container&, const std::string_view, const msgpackValue&), void (*updateFunc)(const container&, updateObject&)>
+void MsgPackArrayParser<container, updateObject, containerUpdateFunc, updateFunc>::parseMsgPackArray(const std::string_view message, updateObject& update_object)
+{
+	//one pass over the message - only values inside the maps are stepped over as a whole
+	msgpackReader reader(message);
+	msgpackValue value = reader.descend();
+
+	if (value.type == msgpackType::MAP) parseMap(reader, value.count, update_object);
+	else if (value.type == msgpackType::ARRAY)
+	{
+		for (uint32_t index = 0; index < value.count; ++index)
+		{
+			msgpackValue element = reader.descend();
+
+			if (element.type != msgpackType::MAP) throw std::runtime_error("MessagePack array elements must be maps.");
+
+			parseMap(reader, element.count, update_object);
+		}
+	}
+	else throw std::runtime_error("MessagePack message must be an array or a map.");
+}
+
+#endif
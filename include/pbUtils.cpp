@@ -0,0 +1,231 @@
+#include "pbUtils.h"
+
+#include <cstring>
+
+//maps every byte to its base64 value - 64 marks padding and whitespace (skipped) and 65 marks invalid characters
+static constexpr unsigned char base64_values[256] =
+{
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 64, 64, 65, 65, 64, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+	64, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 62, 65, 62, 65, 63,
+	52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 65, 65, 65, 64, 65, 65,
+	65,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+	15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 65, 65, 65, 65, 63,
+	65, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+	41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 65, 65, 65, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65
+};
+
+size_t base64DecodeInPlace(char* text, const size_t length)
+{
+	//the write position trails the read position by at least a quarter of the bytes read so nothing is overwritten before it is read
+	//'-' and '_' decode as '+' and '/' so the url safe alphabet works as well
+	unsigned char* output = reinterpret_cast<unsigned char*>(text);
+	const unsigned char* input = output;
+
+	uint32_t bits = 0;
+	int bit_count = 0;
+
+	for (size_t index = 0; index < length; ++index)
+	{
+		unsigned char value = base64_values[input[index]];
+
+		if (value == 64) continue;
+		if (value == 65) throw std::runtime_error("Invalid base64 character.");
+
+		bits = bits << 6 | value;
+		bit_count += 6;
+
+		if (bit_count >= 8)
+		{
+			bit_count -= 8;
+			*output++ = static_cast<unsigned char>(bits >> bit_count);
+		}
+	}
+
+	return output - reinterpret_cast<unsigned char*>(text);
+}
+
+protobufReader::protobufReader(const char* data, const size_t length)
+	: c(reinterpret_cast<const unsigned char*>(data)), end(reinterpret_cast<const unsigned char*>(data) + length), field_number(0), field_wire_type(0) {}
+
+bool protobufReader::next()
+{
+	if (c >= end) return false;
+
+	uint64_t key = varint();
+
+	field_number = static_cast<uint32_t>(key >> 3);
+	field_wire_type = static_cast<uint32_t>(key & 0x7);
+
+	if (field_number == 0) throw std::runtime_error("Invalid protobuf field number.");
+
+	return true;
+}
+
+uint64_t protobufReader::varint()
+{
+	uint64_t value = 0;
+
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (c >= end) throw std::runtime_error("Truncated protobuf varint.");
+
+		unsigned char byte = *c++;
+
+		value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+		if (!(byte & 0x80)) return value;
+	}
+
+	throw std::runtime_error("Protobuf varint is too long.");
+}
+
+int64_t protobufReader::zigzag()
+{
+	uint64_t value = varint();
+
+	return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+float protobufReader::fixed32_float()
+{
+	if (end - c < 4) throw std::runtime_error("Truncated protobuf fixed32 field.");
+
+	//fixed width fields are little endian on the wire - assembling them byte by byte works on any system
+	uint32_t bits = static_cast<uint32_t>(c[0]) | static_cast<uint32_t>(c[1]) << 8 | static_cast<uint32_t>(c[2]) << 16 | static_cast<uint32_t>(c[3]) << 24;
+	float value;
+
+	memcpy(&value, &bits, 4);
+	c += 4;
+
+	return value;
+}
+
+double protobufReader::fixed64_double()
+{
+	if (end - c < 8) throw std::runtime_error("Truncated protobuf fixed64 field.");
+
+	uint64_t bits = 0;
+	double value;
+
+	for (int index = 7; index >= 0; --index) bits = bits << 8 | c[index];
+
+	memcpy(&value, &bits, 8);
+	c += 8;
+
+	return value;
+}
+
+std::string_view protobufReader::bytes()
+{
+	uint64_t length = varint();
+
+	if (static_cast<uint64_t>(end - c) < length) throw std::runtime_error("Truncated protobuf length delimited field.");
+
+	std::string_view value(reinterpret_cast<const char*>(c), static_cast<size_t>(length));
+
+	c += length;
+
+	return value;
+}
+
+void protobufReader::skip()
+{
+	switch (field_wire_type)
+	{
+	case 0: varint(); break;
+	case 1: if (end - c < 8) throw std::runtime_error("Truncated protobuf fixed64 field."); c += 8; break;
+	case 2: bytes(); break;
+	case 5: if (end - c < 4) throw std::runtime_error("Truncated protobuf fixed32 field."); c += 4; break;
+	default: throw std::runtime_error("Unsupported protobuf wire type.");
+	}
+}
+
+void yahooPricingData::clear() noexcept
+{
+	memset(this, 0, sizeof(yahooPricingData));
+}
+
+//wire type of each PricingData field that is kept - 7 (unused by protobuf) for fields that are skipped
+static constexpr unsigned char pricing_wire_types[27] = { 7, 2, 5, 0, 7, 7, 0, 0, 5, 0, 5, 5, 5, 7, 7, 7, 7, 7, 7, 7, 7, 7, 0, 5, 0, 5, 0 };
+
+void parseYahooPricingData(char* message, const size_t length, yahooPricingData& pricing_data)
+{
+	char* text = message;
+	size_t text_length = length;
+
+	while (text_length && (*text == ' ' || *text == '\n' || *text == '\r' || *text == '\t')) { ++text; --text_length; }
+
+	//newer versions of the stream wrap the base64 text in a json object - {"type":"pricing","message":"..."}
+	if (text_length && *text == '{')
+	{
+		std::string_view json(text, text_length);
+		size_t index = json.find("\"message\"");
+
+		if (index == std::string_view::npos) throw std::runtime_error("Yahoo message has no message field.");
+
+		index = json.find('"', json.find(':', index + 9));
+
+		if (index == std::string_view::npos) throw std::runtime_error("Yahoo message field is not a string.");
+
+		size_t close = json.find('"', index + 1);
+
+		if (close == std::string_view::npos) throw std::runtime_error("Invalid JSON Format.");
+
+		text += index + 1;
+		text_length = close - index - 1;
+	}
+
+	protobufReader reader(text, base64DecodeInPlace(text, text_length));
+
+	while (reader.next())
+	{
+		if (reader.field() >= sizeof(pricing_wire_types) || reader.wire_type() != pricing_wire_types[reader.field()])
+		{
+			reader.skip();
+
+			continue;
+		}
+
+		switch (reader.field())
+		{
+		case 1:
+		{
+			std::string_view id = reader.bytes();
+
+			pricing_data.symbol_length = static_cast<uint8_t>(id.size() < PB_UTILS_SYMBOL_SIZE ? id.size() : PB_UTILS_SYMBOL_SIZE);
+			memcpy(pricing_data.symbol, id.data(), pricing_data.symbol_length);
+
+			break;
+		}
+		case 2: pricing_data.price = reader.fixed32_float(); break;
+		case 3: pricing_data.time = reader.zigzag(); break;
+		case 6: pricing_data.quote_type = static_cast<int32_t>(reader.varint()); break;
+		case 7: pricing_data.market_hours = static_cast<int32_t>(reader.varint()); break;
+		case 8: pricing_data.change_percent = reader.fixed32_float(); break;
+		case 9: pricing_data.day_volume = reader.zigzag(); break;
+		case 10: pricing_data.day_high = reader.fixed32_float(); break;
+		case 11: pricing_data.day_low = reader.fixed32_float(); break;
+		case 12: pricing_data.change = reader.fixed32_float(); break;
+		case 22: pricing_data.last_size = reader.zigzag(); break;
+		case 23: pricing_data.bid = reader.fixed32_float(); break;
+		case 24: pricing_data.bid_size = reader.zigzag(); break;
+		case 25: pricing_data.ask = reader.fixed32_float(); break;
+		case 26: pricing_data.ask_size = reader.zigzag(); break;
+		default: reader.skip(); break;
+		}
+	}
+}
+
+void parseYahooPricingData(std::string& message, yahooPricingData& pricing_data)
+{
+	parseYahooPricingData(&message[0], message.size(), pricing_data);
+}
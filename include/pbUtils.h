@@ -0,0 +1,90 @@
+
+//zero-allocation decoding of the base64 protobuf messages sent by the yahoo finance streamer (streamer.finance.yahoo.com)
+
+#ifndef PB_UTILS_H
+#define PB_UTILS_H
+
+#define PB_UTILS_SYMBOL_SIZE 32 //longest symbol kept - longer ids are truncated
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+//decode base64 text over itself (the decoded bytes are never longer than the text) - returns the decoded length
+size_t base64DecodeInPlace(char*, const size_t);
+
+/*
+a reader for the protobuf wire format
+it walks a buffer one field at a time without building anything - the caller decides what to do with each field number
+*/
+
+class protobufReader
+{
+public:
+	protobufReader(const char*, const size_t);
+
+	bool next(); //move to the next field - false once the end of the buffer is reached
+
+	inline uint32_t field() const noexcept { return field_number; }
+	inline uint32_t wire_type() const noexcept { return field_wire_type; }
+
+	uint64_t varint(); //wire type 0 - int32, int64, uint32, uint64, bool, and enum fields
+	int64_t zigzag(); //wire type 0 - sint32 and sint64 fields
+	float fixed32_float(); //wire type 5
+	double fixed64_double(); //wire type 1
+	std::string_view bytes(); //wire type 2 - strings, bytes, and embedded messages (points into the buffer)
+
+	void skip(); //skip the value of a field that is not needed
+
+private:
+	const unsigned char* c;
+	const unsigned char* end;
+
+	uint32_t field_number;
+	uint32_t field_wire_type;
+};
+
+/*
+the fields of the yahoo PricingData message that are kept (field numbers from yahoo's pricing.proto)
+every update only carries the fields that changed, so a field that is not in the message keeps the value from the previous one ...
+... call clear() first to start from zeros instead
+*/
+
+struct yahooPricingData
+{
+	char symbol[PB_UTILS_SYMBOL_SIZE]; //1 - id
+	uint8_t symbol_length;
+
+	float price; //2
+	int64_t time; //3 - milliseconds since the epoch
+	int32_t quote_type; //6 - 8 is equity, 41 is cryptocurrency, ...
+	int32_t market_hours; //7 - 0 pre market, 1 regular market, 2 post market, 3 extended hours
+	float change_percent; //8
+	int64_t day_volume; //9
+	float day_high; //10
+	float day_low; //11
+	float change; //12
+	int64_t last_size; //22
+	float bid; //23
+	int64_t bid_size; //24
+	float ask; //25
+	int64_t ask_size; //26
+
+	void clear() noexcept;
+
+	inline std::string_view get_symbol() const noexcept { return std::string_view(symbol, symbol_length); }
+};
+
+/*
+decode a message from the yahoo streamer into a yahooPricingData struct without allocating
+the message can be the bare base64 text or a json wrapper with the base64 text in its "message" field - either way it is decoded in place ...
+... so the buffer holds protobuf bytes afterwards
+throws std::runtime_error on invalid base64 or a malformed protobuf message
+*/
+
+void parseYahooPricingData(char*, const size_t, yahooPricingData&);
+void parseYahooPricingData(std::string&, yahooPricingData&);
+
+#endif
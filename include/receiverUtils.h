@@ -0,0 +1,307 @@
+
+//run websocket reads on a dedicated (optionally pinned) thread and hand completed messages to the consumer through a lock-free queue
+
+#ifndef RECEIVER_UTILS_H
+#define RECEIVER_UTILS_H
+
+#include "exceptUtils.h"
+#include "socketUtils.h"
+#include "wsUtils.h"
+#include "spscUtils.h"
+#include "statUtils.h"
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32) && defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+//pin the calling thread to one cpu core - returns false if the platform does not support it or the core does not exist
+inline bool pinCurrentThread(const int core)
+{
+	if (core < 0) return false;
+
+#ifdef _WIN32
+
+	return core < 64 && SetThreadAffinityMask(GetCurrentThread(), 1ULL << core) != 0;
+
+#elif defined(__linux__)
+
+	if (core >= CPU_SETSIZE) return false;
+
+	cpu_set_t cpu_set;
+
+	CPU_ZERO(&cpu_set);
+	CPU_SET(core, &cpu_set);
+
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+
+#else
+
+	return false;
+
+#endif
+}
+
+//a received websocket message and its receive timestamps (see websocket::message_kernel_ns)
+struct wsMessage
+{
+	std::string payload;
+
+	int64_t kernel_ns = 0;
+	int64_t user_ns = 0;
+	int64_t complete_ns = 0;
+};
+
+//the default parser - copies the payload into the slot's reused string
+inline bool copyMessage(const websocket& ws, const std::string_view payload, wsMessage& message)
+{
+	message.payload.assign(payload.data(), payload.size());
+
+	message.kernel_ns = ws.message_kernel_ns;
+	message.user_ns = ws.message_user_ns;
+	message.complete_ns = ws.message_complete_ns;
+
+	return true;
+}
+
+/*
+receives from an open non-blocking websocket on its own thread and publishes every message into an spscQueue
+
+the parser runs on the receive thread and fills a queue slot in place from the payload view - returning false skips the message ...
+... so messages can be decoded into structs before they reach the consumer and pings never take a slot
+when the queue is full the message is dropped and counted rather than stalling the socket
+
+once start is called only the receive thread may use the websocket until stop returns (an ssl connection cannot be written and read from two threads at once) ...
+... so messages sent while it runs (subscriptions) go through send, which hands them to the receive thread to write between reads
+if recv throws (the connection closed or timed out), the receive thread stops and failed() becomes true ...
+... and rethrow() throws the same exception on the consumer thread
+*/
+
+template <typename messageType, size_t capacity>
+class wsReceiver
+{
+public:
+	typedef std::function<bool(const websocket&, const std::string_view, messageType&)> parserType;
+
+	wsReceiver(websocket&, const parserType, const int); //websocket, parser, core to pin the receive thread to (-1 to not pin)
+	wsReceiver(const wsReceiver&);
+	~wsReceiver();
+
+	wsReceiver& operator=(const wsReceiver&);
+
+	void start();
+	void stop(); //messages still waiting to be sent are written on the calling thread
+
+	void send(const std::string&, const char); //message, websocket header - queued for the receive thread, or sent straight away if it isn't running
+
+	//consumer side
+	inline messageType* front() noexcept { return queue.front(); } //oldest message or nullptr - read it in place and then call pop
+	inline void pop() noexcept { queue.pop(); }
+	inline bool try_pop(messageType& message) { return queue.try_pop(message); }
+
+	inline size_t depth() const noexcept { return queue.size(); } //messages waiting for the consumer
+	inline uint64_t max_depth() const noexcept { return deepest.get(); } //highest depth seen by the receive thread
+	inline uint64_t received() const noexcept { return published.get(); } //messages published to the queue
+	inline uint64_t drops() const noexcept { return dropped.get(); } //messages dropped because the queue was full
+
+	inline bool pinned() const noexcept { return is_pinned.load(std::memory_order_acquire); }
+	inline bool failed() const noexcept { return has_failed.load(std::memory_order_acquire); }
+	void rethrow() const; //throw the exception that stopped the receive thread, if there was one
+
+private:
+	void run();
+	void sendQueued(); //write the messages handed over by send - the caller must own the websocket
+
+	websocket& ws;
+	parserType parser;
+	int core;
+
+	spscQueue<messageType, capacity> queue;
+
+	std::atomic<bool> running;
+	std::atomic<bool> is_pinned;
+	std::atomic<bool> has_failed;
+
+	std::exception_ptr error; //written by the receive thread before has_failed is set
+
+	std::mutex outbox_mutex;
+	std::vector<std::pair<std::string, char>> outbox; //guarded by outbox_mutex
+	std::vector<std::pair<std::string, char>> sending; //swapped with outbox so messages are written without holding the lock
+	std::atomic<bool> outbox_pending;
+
+	statCounter published;
+	statCounter dropped;
+	statCounter deepest;
+
+	std::thread receive_thread;
+};
+
+template <typename messageType, size_t capacity>
+wsReceiver<messageType, capacity>::wsReceiver(websocket& Ws, const parserType Parser, const int Core)
+	: ws(Ws), parser(Parser), core(Core), running(false), is_pinned(false), has_failed(false), outbox_pending(false)
+{
+	//a blocking recv could sit in the kernel forever and stop would never return
+	if (ws.is_blocking()) throw std::runtime_error("wsReceiver needs a non-blocking websocket.");
+}
+
+template <typename messageType, size_t capacity>
+wsReceiver<messageType, capacity>::wsReceiver(const wsReceiver& other) : ws(other.ws)
+{
+	throw std::runtime_error("wsReceiver type doesn't support copy construction.");
+}
+
+template <typename messageType, size_t capacity>
+wsReceiver<messageType, capacity>::~wsReceiver()
+{
+	stop();
+}
+
+template <typename messageType, size_t capacity>
+wsReceiver<messageType, capacity>& wsReceiver<messageType, capacity>::operator=(const wsReceiver& other)
+{
+	throw std::runtime_error("wsReceiver type doesn't support item assignment.");
+}
+
+template <typename messageType, size_t capacity>
+void wsReceiver<messageType, capacity>::start()
+{
+	if (running.load(std::memory_order_acquire)) return;
+	if (!ws.opened) throw exceptions::exception("The websocket must be open before its receiver is started.");
+
+	has_failed.store(false, std::memory_order_release);
+	error = nullptr;
+
+	//anything still queued was meant for a connection that failed
+	{
+		std::lock_guard<std::mutex> guard(outbox_mutex);
+
+		outbox.clear();
+		outbox_pending.store(false, std::memory_order_relaxed);
+	}
+
+	running.store(true, std::memory_order_release);
+	receive_thread = std::thread(&wsReceiver::run, this);
+}
+
+template <typename messageType, size_t capacity>
+void wsReceiver<messageType, capacity>::stop()
+{
+	running.store(false, std::memory_order_release);
+
+	if (receive_thread.joinable()) receive_thread.join();
+
+	if (!outbox_pending.load(std::memory_order_acquire) || has_failed.load(std::memory_order_acquire)) return;
+
+	//this thread owns the websocket again - a failure is reported the same way as one on the receive thread
+	try { sendQueued(); }
+	catch (...)
+	{
+		error = std::current_exception();
+
+		has_failed.store(true, std::memory_order_release);
+	}
+}
+
+template <typename messageType, size_t capacity>
+void wsReceiver<messageType, capacity>::send(const std::string& message, const char header)
+{
+	if (!running.load(std::memory_order_acquire))
+	{
+		ws.send(message, header);
+
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(outbox_mutex);
+
+		outbox.emplace_back(message, header);
+	}
+
+	outbox_pending.store(true, std::memory_order_release);
+}
+
+template <typename messageType, size_t capacity>
+void wsReceiver<messageType, capacity>::sendQueued()
+{
+	{
+		std::lock_guard<std::mutex> guard(outbox_mutex);
+
+		sending.swap(outbox);
+		outbox_pending.store(false, std::memory_order_relaxed);
+	}
+
+	for (const auto& message : sending) ws.send(message.first, message.second);
+
+	sending.clear();
+}
+
+template <typename messageType, size_t capacity>
+void wsReceiver<messageType, capacity>::rethrow() const
+{
+	if (has_failed.load(std::memory_order_acquire) && error) std::rethrow_exception(error);
+}
+
+template <typename messageType, size_t capacity>
+void wsReceiver<messageType, capacity>::run()
+{
+	is_pinned.store(pinCurrentThread(core), std::memory_order_release);
+
+	std::string_view payload;
+
+	try
+	{
+		while (running.load(std::memory_order_relaxed))
+		{
+			if (outbox_pending.load(std::memory_order_acquire)) sendQueued();
+
+			//recv also returns false after a control frame with data frames still buffered, so only wait on the socket once the buffer is empty
+			//the websocket's wait strategy decides between spinning and polling - its block time bounds how long stop takes
+			if (!ws.recv(payload))
+			{
+				if (!ws.buffered()) ws.idle();
+
+				continue;
+			}
+
+			if (ws.frame_header & WS_OPCODE_BITS & 0x8) continue; //a control frame returned because signal_on_control is set
+
+			messageType* slot = queue.write_slot();
+
+			if (slot == nullptr)
+			{
+				dropped.add(1);
+
+				continue;
+			}
+
+			if (!parser(ws, payload, *slot)) continue;
+
+			queue.publish();
+			published.add(1);
+
+			uint64_t current_depth = queue.size();
+
+			if (current_depth > deepest.get()) deepest.set(current_depth);
+		}
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+
+		has_failed.store(true, std::memory_order_release);
+		running.store(false, std::memory_order_release);
+	}
+}
+
+#endif
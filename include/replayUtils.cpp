@@ -0,0 +1,480 @@
+#include "replayUtils.h"
+
+#include <openssl/sha.h>
+#include <openssl/evp.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <fstream>
+
+#ifndef _WIN32
+#include <netinet/tcp.h> //for TCP_NODELAY
+#endif
+
+#define REPLAY_UTILS_HANDSHAKE_TIMEOUT_MS 5000
+#define REPLAY_UTILS_READ_SIZE 4096
+
+constexpr const char* WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"; //appended to the client's key to build Sec-WebSocket-Accept
+
+//append an unmasked frame - server frames are never masked
+static void appendFrame(std::string& out, const char first_byte, const char* payload, const size_t length)
+{
+	out += first_byte;
+
+	if (length < 0x7e) out += static_cast<char>(length);
+	else if (length < 0x10000)
+	{
+		out += static_cast<char>(0x7e);
+		out += static_cast<char>(length >> 8);
+		out += static_cast<char>(length);
+	}
+	else
+	{
+		out += static_cast<char>(0x7f);
+
+		for (int index = 7; index >= 0; --index) out += static_cast<char>(static_cast<uint64_t>(length) >> (8 * index));
+	}
+
+	out.append(payload, length);
+}
+
+//write everything - returns false once the client is gone
+static bool sendAll(socketFD client, const std::string& data)
+{
+	size_t sent = 0;
+
+	while (sent < data.size())
+	{
+		int chunk = static_cast<int>(std::min<size_t>(data.size() - sent, INT_MAX));
+		int bytes = send(client, data.data() + sent, chunk, SOCKET_UTILS_SEND_FLAGS);
+
+		if (bytes <= 0) return false;
+
+		sent += bytes;
+	}
+
+	return true;
+}
+
+static bool waitReadable(socketFD client, const int timeout_ms)
+{
+	pollfd descriptor{};
+
+	descriptor.fd = client;
+	descriptor.events = POLLIN;
+
+#ifdef _WIN32
+
+	return WSAPoll(&descriptor, 1, timeout_ms) > 0;
+
+#else
+
+	return poll(&descriptor, 1, timeout_ms) > 0;
+
+#endif
+}
+
+replayServer::replayServer(const uint16_t Port, const replayOptions& Options)
+	: port(Port), options(Options), listen_socket(INVALID_SOCKET), running(false), session_count(0), delivered_messages(0), delivered_payload(0), last_rate(0)
+{
+	if (options.speed < 0) throw std::runtime_error("Replay speed can't be negative.");
+	if (options.batch == 0) options.batch = 1;
+}
+
+replayServer::replayServer(const replayServer& other_server)
+{
+	throw std::runtime_error("replayServer type doesn't support copy construction.");
+}
+
+replayServer::~replayServer()
+{
+	stop();
+}
+
+replayServer& replayServer::operator=(const replayServer& other_server)
+{
+	throw std::runtime_error("replayServer type doesn't support item assignment.");
+}
+
+void replayServer::add(const int64_t timestamp_ns, const std::string_view payload)
+{
+	if (running.load(std::memory_order_acquire)) throw std::runtime_error("Messages can't be added while the replay server is running.");
+	if (!messages.empty() && timestamp_ns < messages.back().timestamp_ns) throw std::runtime_error("Replay messages must be added in the order they were received.");
+
+	messages.push_back(replayMessage{ timestamp_ns, std::string(payload) });
+}
+
+size_t replayServer::loadLines(const std::string& path, const int64_t interval_ns)
+{
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file) throw exceptions::exception("Could not open the replay file: " + path);
+
+	std::string line;
+	size_t count = 0;
+	int64_t timestamp_ns = messages.empty() ? 0 : messages.back().timestamp_ns + interval_ns;
+
+	while (std::getline(file, line))
+	{
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		if (line.empty()) continue;
+
+		add(timestamp_ns, line);
+
+		timestamp_ns += interval_ns;
+		++count;
+	}
+
+	return count;
+}
+
+size_t replayServer::loadCapture(const std::string& path)
+{
+	captureReader reader(path);
+	captureRecord record;
+
+	size_t count = 0;
+
+	//control frames were answered by the client when they were captured and are not replayed
+	while (reader.next(record))
+	{
+		if (record.opcode != WS_TEXT_OPCODE && record.opcode != WS_BINARY_OPCODE) continue;
+
+		add(record.timestamp_ns, record.payload);
+
+		++count;
+	}
+
+	return count;
+}
+
+void replayServer::start()
+{
+	if (running.load(std::memory_order_acquire)) return;
+	if (messages.empty()) throw exceptions::exception("The replay server has no messages to replay.");
+
+	listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+
+	if (listen_socket == INVALID_SOCKET) throw std::runtime_error("Could not create the replay server socket.");
+
+	int reuse = 1;
+
+	setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+	sockaddr_in address{};
+
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if (bind(listen_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listen_socket, SOMAXCONN) != 0)
+	{
+		closeSocket(listen_socket);
+
+		throw std::runtime_error("Could not listen on port " + std::to_string(port) + " for the replay server.");
+	}
+
+	running.store(true, std::memory_order_release);
+	accept_thread = std::thread(&replayServer::acceptClients, this);
+}
+
+void replayServer::stop()
+{
+	running.store(false, std::memory_order_release);
+
+	if (accept_thread.joinable()) accept_thread.join();
+
+	std::vector<std::thread> finished_threads;
+
+	{
+		std::lock_guard<std::mutex> lock(client_mutex);
+
+		//a client that stopped reading leaves its thread blocked in send once the socket buffer fills
+		for (socketFD client : client_sockets)
+		{
+#ifdef _WIN32
+
+			shutdown(client, SD_BOTH);
+
+#else
+
+			shutdown(client, SHUT_RDWR);
+
+#endif
+		}
+
+		finished_threads.swap(client_threads);
+	}
+
+	for (std::thread& client_thread : finished_threads) if (client_thread.joinable()) client_thread.join();
+
+	closeSocket(listen_socket);
+}
+
+double replayServer::last_session_rate() const
+{
+	std::lock_guard<std::mutex> lock(rate_mutex);
+
+	return last_rate;
+}
+
+void replayServer::acceptClients()
+{
+	while (running.load(std::memory_order_acquire))
+	{
+		if (!waitReadable(listen_socket, REPLAY_UTILS_ACCEPT_POLL_MS)) continue;
+
+		socketFD client = accept(listen_socket, nullptr, nullptr);
+
+		if (client == INVALID_SOCKET) continue;
+
+		int no_delay = 1;
+
+		setsockopt(client, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&no_delay), sizeof(no_delay));
+
+		std::lock_guard<std::mutex> lock(client_mutex);
+
+		client_sockets.push_back(client);
+		client_threads.emplace_back(&replayServer::serveClient, this, client);
+	}
+}
+
+void replayServer::closeClient(socketFD client)
+{
+	//closed under the lock so stop never shuts down a descriptor that was reused for another socket
+	std::lock_guard<std::mutex> lock(client_mutex);
+
+	client_sockets.erase(std::find(client_sockets.begin(), client_sockets.end(), client));
+	closeSocket(client);
+}
+
+void replayServer::serveClient(socketFD client)
+{
+	char buffer[REPLAY_UTILS_READ_SIZE];
+
+	std::string incoming;
+	std::string outgoing;
+
+	//read the upgrade request
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(REPLAY_UTILS_HANDSHAKE_TIMEOUT_MS);
+
+	while (incoming.find("\r\n\r\n") == std::string::npos)
+	{
+		if (!running.load(std::memory_order_acquire) || std::chrono::steady_clock::now() > deadline) { closeClient(client); return; }
+		if (!waitReadable(client, REPLAY_UTILS_ACCEPT_POLL_MS)) continue;
+
+		int bytes = recv(client, buffer, REPLAY_UTILS_READ_SIZE, 0);
+
+		if (bytes <= 0) { closeClient(client); return; }
+
+		incoming.append(buffer, bytes);
+	}
+
+	//header names are case insensitive
+	std::string request(incoming, 0, incoming.find("\r\n\r\n") + 2);
+
+	std::transform(request.begin(), request.end(), request.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	size_t key_start = request.find("sec-websocket-key:");
+
+	if (key_start == std::string::npos)
+	{
+		sendAll(client, "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n");
+		closeClient(client);
+
+		return;
+	}
+
+	key_start += 18;
+
+	size_t key_end = request.find("\r\n", key_start);
+
+	//the key is case sensitive so it is taken from the original request
+	std::string key = incoming.substr(key_start, key_end - key_start);
+
+	key.erase(0, key.find_first_not_of(' '));
+	key.erase(key.find_last_not_of(' ') + 1);
+	key += WEBSOCKET_GUID;
+
+	unsigned char digest[SHA_DIGEST_LENGTH];
+	unsigned char accept_key[4 * ((SHA_DIGEST_LENGTH + 2) / 3) + 1];
+
+	SHA1(reinterpret_cast<const unsigned char*>(key.data()), key.size(), digest);
+	EVP_EncodeBlock(accept_key, digest, SHA_DIGEST_LENGTH);
+
+	if (!sendAll(client, std::string("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: ") +
+		reinterpret_cast<const char*>(accept_key) + "\r\n\r\n"))
+	{
+		closeClient(client);
+
+		return;
+	}
+
+	incoming.erase(0, incoming.find("\r\n\r\n") + 4);
+	session_count.fetch_add(1, std::memory_order_relaxed);
+
+	const char data_frame = options.binary ? WS_BINARY_FRAME : WS_TEXT_FRAME;
+	const char first_fragment = data_frame & ~WS_FIN_BIT;
+	const char last_fragment = WS_FIN_BIT | WS_CONTINUATION_OPCODE;
+	const char middle_fragment = WS_CONTINUATION_OPCODE;
+
+	const int64_t base_ns = messages.front().timestamp_ns;
+
+	uint64_t session_messages = 0;
+	size_t batched = 0;
+	bool connected = true;
+
+	const auto connect_time = std::chrono::steady_clock::now(); //the rate covers every pass of a looping session
+	auto session_start = connect_time; //pacing restarts with each pass
+	auto next_ping = session_start + std::chrono::milliseconds(options.ping_interval_ms);
+
+	//read and discard whatever the client sent - returns false once the client closed the connection or sent a close frame
+	auto drainClient = [&]() -> bool
+	{
+		while (waitReadable(client, 0))
+		{
+			int bytes = recv(client, buffer, REPLAY_UTILS_READ_SIZE, 0);
+
+			if (bytes <= 0) return false;
+
+			incoming.append(buffer, bytes);
+		}
+
+		while (incoming.size() >= 2)
+		{
+			size_t length = incoming[1] & 0x7f;
+			size_t header_length = 2 + (length == 0x7e ? 2 : length == 0x7f ? 8 : 0) + (incoming[1] & 0x80 ? 4 : 0);
+
+			if (incoming.size() < header_length) break;
+
+			if (length == 0x7e) length = static_cast<unsigned char>(incoming[2]) << 8 | static_cast<unsigned char>(incoming[3]);
+			else if (length == 0x7f)
+			{
+				length = 0;
+
+				for (size_t index = 2; index < 10; ++index) length = length << 8 | static_cast<unsigned char>(incoming[index]);
+			}
+
+			if (incoming.size() < header_length + length) break;
+			if ((incoming[0] & WS_OPCODE_BITS) == WS_CLOSE_OPCODE) return false;
+
+			incoming.erase(0, header_length + length);
+		}
+
+		return true;
+	};
+
+	do
+	{
+		for (size_t index = 0; index < messages.size() && connected && running.load(std::memory_order_relaxed); ++index)
+		{
+			const replayMessage& message = messages[index];
+
+			if (options.speed > 0)
+			{
+				auto send_time = session_start + std::chrono::nanoseconds(static_cast<int64_t>((message.timestamp_ns - base_ns) / options.speed));
+
+				if (std::chrono::steady_clock::now() < send_time)
+				{
+					//anything batched goes out before waiting so it is not delayed
+					if (!outgoing.empty())
+					{
+						connected = sendAll(client, outgoing);
+						outgoing.clear();
+						batched = 0;
+					}
+
+					if (send_time - std::chrono::steady_clock::now() > std::chrono::nanoseconds(REPLAY_UTILS_SPIN_NS))
+					{
+						std::this_thread::sleep_until(send_time - std::chrono::nanoseconds(REPLAY_UTILS_SPIN_NS));
+					}
+
+					while (std::chrono::steady_clock::now() < send_time) continue;
+				}
+			}
+
+			if (options.ping_interval_ms > 0 && std::chrono::steady_clock::now() >= next_ping)
+			{
+				appendFrame(outgoing, WS_PING_FRAME, "replay", 6);
+
+				next_ping += std::chrono::milliseconds(options.ping_interval_ms);
+			}
+
+			const char* payload = message.payload.data();
+			size_t remaining = message.payload.size();
+
+			if (options.fragment_size == 0 || remaining <= options.fragment_size) appendFrame(outgoing, data_frame, payload, remaining);
+			else
+			{
+				for (bool first = true; remaining; first = false)
+				{
+					size_t length = std::min(remaining, options.fragment_size);
+
+					appendFrame(outgoing, first ? first_fragment : length == remaining ? last_fragment : middle_fragment, payload, length);
+
+					payload += length;
+					remaining -= length;
+				}
+			}
+
+			if (++batched >= options.batch)
+			{
+				connected = sendAll(client, outgoing) && drainClient();
+				outgoing.clear();
+				batched = 0;
+			}
+
+			++session_messages;
+
+			delivered_messages.fetch_add(1, std::memory_order_relaxed);
+			delivered_payload.fetch_add(message.payload.size(), std::memory_order_relaxed);
+		}
+
+		if (connected && !outgoing.empty())
+		{
+			connected = sendAll(client, outgoing) && drainClient();
+			outgoing.clear();
+			batched = 0;
+		}
+
+		if (options.loop) session_start = std::chrono::steady_clock::now();
+	}
+	while (options.loop && connected && running.load(std::memory_order_relaxed));
+
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - connect_time).count();
+
+	if (connected)
+	{
+		//normal closure (1000)
+		outgoing.clear();
+		appendFrame(outgoing, WS_CLOSE_FRAME, "\x03\xe8", 2);
+		sendAll(client, outgoing);
+
+		//closing with client frames still unread resets the connection and throws away whatever the client has not read yet ...
+		//... so stop writing and wait for the client to close its side
+#ifdef _WIN32
+
+		shutdown(client, SD_SEND);
+
+#else
+
+		shutdown(client, SHUT_WR);
+
+#endif
+
+		deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(REPLAY_UTILS_HANDSHAKE_TIMEOUT_MS);
+
+		while (running.load(std::memory_order_relaxed) && std::chrono::steady_clock::now() < deadline)
+		{
+			if (waitReadable(client, REPLAY_UTILS_ACCEPT_POLL_MS) && recv(client, buffer, REPLAY_UTILS_READ_SIZE, 0) <= 0) break;
+		}
+	}
+
+	closeClient(client);
+
+	std::lock_guard<std::mutex> lock(rate_mutex);
+
+	last_rate = elapsed > 0 ? session_messages / elapsed : 0;
+}
@@ -0,0 +1,103 @@
+
+//a local websocket server that replays recorded messages to its clients - used to load test websocket::recv and message parsing without a live feed
+
+#ifndef REPLAY_UTILS_H
+#define REPLAY_UTILS_H
+
+#define REPLAY_UTILS_ACCEPT_POLL_MS 100 //how often the accepting thread checks whether the server is stopping
+#define REPLAY_UTILS_SPIN_NS 200000 //sleep until this close to a message's send time and spin for the rest
+
+#include "exceptUtils.h"
+#include "socketUtils.h"
+#include "wsUtils.h"
+#include "captureUtils.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+struct replayOptions
+{
+	double speed = 1.0; //1 replays at the recorded rate, 10 is ten times faster, and 0 sends as fast as the client reads
+	size_t fragment_size = 0; //largest payload per frame - longer messages are split into continuation frames (0 never splits)
+	size_t batch = 1; //number of frames written with each send call - larger batches put more frames in each read on the client
+	int ping_interval_ms = 0; //send a ping frame this often (0 never pings)
+	bool loop = false; //start over at the first message after the last one instead of closing the connection
+	bool binary = false; //send binary frames instead of text frames
+};
+
+//a recorded message and when it was received - only the differences between timestamps matter
+struct replayMessage
+{
+	int64_t timestamp_ns;
+
+	std::string payload;
+};
+
+/*
+listens on the loopback interface over plain tcp and replays the loaded messages to every client that upgrades to a websocket
+each client gets its own thread and its own pass over the messages, paced by the recorded offsets divided by speed
+frames are sent unmasked as a server's frames are - anything the client sends (subscriptions, pongs) is read and discarded ...
+... and a close frame or a dropped connection ends that client's session
+
+send calls block while the client's receive buffer is full, so at speed 0 the delivered rate is the rate the client can absorb
+messages must be loaded before start
+*/
+
+class replayServer
+{
+public:
+	replayServer(const uint16_t, const replayOptions&); //port, options
+	replayServer(const replayServer&);
+	~replayServer();
+
+	replayServer& operator=(const replayServer&);
+
+	void add(const int64_t, const std::string_view); //append a message received at the given nanoseconds
+	size_t loadLines(const std::string&, const int64_t); //append every line of a text file as a message spaced by the given nanoseconds - returns the number of messages
+	size_t loadCapture(const std::string&); //append the text and binary messages of a capture file (captureUtils.h) at their recorded times - returns the number of messages
+
+	void start();
+	void stop();
+
+	inline size_t size() const noexcept { return messages.size(); }
+
+	inline uint64_t sessions() const noexcept { return session_count.load(std::memory_order_relaxed); } //clients that completed the upgrade
+	inline uint64_t delivered() const noexcept { return delivered_messages.load(std::memory_order_relaxed); } //messages written to all clients
+	inline uint64_t delivered_bytes() const noexcept { return delivered_payload.load(std::memory_order_relaxed); } //payload bytes written to all clients
+
+	double last_session_rate() const; //messages per second of the last session that ended
+
+private:
+	void acceptClients();
+	void serveClient(socketFD);
+	void closeClient(socketFD); //forget and close a client socket
+
+	uint16_t port;
+	replayOptions options;
+
+	std::vector<replayMessage> messages;
+
+	socketFD listen_socket;
+
+	std::atomic<bool> running;
+
+	std::atomic<uint64_t> session_count;
+	std::atomic<uint64_t> delivered_messages;
+	std::atomic<uint64_t> delivered_payload;
+
+	std::thread accept_thread;
+
+	std::mutex client_mutex;
+	std::vector<std::thread> client_threads;
+	std::vector<socketFD> client_sockets; //connected clients - stop shuts them down so a thread blocked sending to a client that stopped reading returns
+
+	mutable std::mutex rate_mutex;
+	double last_rate;
+};
+
+#endif
@@ -0,0 +1,445 @@
+
+//spread a symbol universe across several websocket connections, each read by its own pinned thread, and merge them into one consumer
+
+#ifndef SHARD_UTILS_H
+#define SHARD_UTILS_H
+
+#define SHARD_UTILS_REBALANCE_TOLERANCE 0.2 //rebalance only moves symbols while the busiest shard is more than this fraction above the mean
+
+#include "exceptUtils.h"
+#include "socketUtils.h"
+#include "httpUtils.h"
+#include "wsUtils.h"
+#include "receiverUtils.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*
+a feed whose symbols are split across one websocket connection per shard
+
+start connects and upgrades every shard, assigns each symbol to a shard by hash, subscribes, and starts one wsReceiver per shard ...
+... pinned to the shard's core - the parser runs on the receive threads so decoding scales with the number of shards
+front and pop serve the shards round robin from the consumer thread - messages of one symbol stay in order ...
+... while a symbol lives on one shard, but there is no order between shards
+
+pop counts messages per symbol using symbol_of, and rebalance moves the hottest symbols from the busiest shards to the quietest ...
+... until no shard is more than SHARD_UTILS_REBALANCE_TOLERANCE above the mean for the messages counted since the last rebalance
+a moved symbol is subscribed on its new shard at once and unsubscribed from the old one only when pop sees its first message from the new shard ...
+... since the two messages go out on different connections and nothing orders them at the server - a move can repeat a few messages but never misses any
+messages for a running shard are handed to its receive thread (wsReceiver::send), which writes them between reads ...
+... so sending never stops the thread - a send that fails marks the shard failed like a failed read
+
+a failed shard stops on its own (failed returns true) and restart reconnects it and subscribes its symbols again
+every member function must be called from the consumer thread
+*/
+
+template <typename messageType, size_t capacity>
+class shardedFeed
+{
+public:
+	typedef typename wsReceiver<messageType, capacity>::parserType parserType;
+	typedef std::function<std::string(const std::vector<std::string>&)> formatterType; //builds a subscribe or unsubscribe message for a list of symbols
+	typedef std::function<std::string_view(const messageType&)> symbolType; //the symbol a parsed message belongs to
+
+	shardedFeed(const SSLContextWrapper&, const std::string, const std::string, const socketTransport, const dictionary&, const std::string, const time_t,
+		const std::vector<int>&, const formatterType, const formatterType, const parserType, const symbolType);
+		//host, port, transport, upgrade headers, path, timeout, one core per shard (-1 to not pin), subscribe, unsubscribe, parser, symbol_of
+	shardedFeed(const shardedFeed&);
+	~shardedFeed();
+
+	shardedFeed& operator=(const shardedFeed&);
+
+	void start(const std::vector<std::string>&); //connect every shard and subscribe to the symbols
+	void stop();
+
+	void setWaitStrategy(const waitStrategy&); //how every shard's receive thread waits between empty reads - call before start
+	void subscribe(const std::string&); //add a symbol to the shard its hash picks
+	void move(const std::string&, const size_t); //move a symbol to a shard
+	size_t rebalance(); //move hot symbols off the busiest shards - returns the number of symbols moved
+	void restart(const size_t); //reconnect a failed shard and subscribe its symbols again
+
+	//consumer side
+	messageType* front() noexcept; //oldest message of the next shard that has one, or nullptr - read it in place and then call pop
+	void pop();
+
+	inline size_t shard_count() const noexcept { return shards.size(); }
+	size_t shard_of(const std::string_view) const; //shard a symbol is assigned to
+	std::vector<std::string> symbols(const size_t) const; //symbols assigned to a shard
+	inline uint64_t load(const size_t shard) const noexcept { return shards[shard]->load; } //messages popped from the shard since the last rebalance
+	inline bool failed(const size_t shard) const noexcept { return shards[shard]->receiver->failed(); }
+
+	wsReceiver<messageType, capacity>& receiver(const size_t shard) noexcept { return *shards[shard]->receiver; } //queue depth, drops, pinning, and errors
+
+private:
+	struct shard
+	{
+		std::unique_ptr<websocket> socket;
+		std::unique_ptr<wsReceiver<messageType, capacity>> receiver;
+
+		uint64_t load = 0;
+	};
+
+	struct symbolState
+	{
+		size_t shard;
+		uint64_t count; //messages since the last rebalance
+		std::vector<size_t> leaving; //shards the symbol moved off - still subscribed until its first message arrives on the new shard
+	};
+
+	//lets the symbol table be searched with the string_view symbol_of returns without building a string
+	struct symbolHash
+	{
+		using is_transparent = void;
+
+		inline size_t operator()(const std::string_view symbol) const noexcept { return std::hash<std::string_view>{}(symbol); }
+	};
+
+	void connect(shard&);
+	bool reassign(symbolState&, const size_t); //point a symbol at a shard - returns false if the shard is one it is still leaving and so still subscribed
+	void send(const size_t, const std::string&); //send on a shard's connection through its receiver
+
+	SSLContextWrapper& ssl_context_wrapper;
+
+	std::string host;
+	std::string port;
+	std::string path;
+	socketTransport transport;
+	dictionary headers;
+	time_t timeout;
+
+	formatterType subscribe_formatter;
+	formatterType unsubscribe_formatter;
+	parserType parser;
+	symbolType symbol_of;
+
+	std::vector<std::unique_ptr<shard>> shards;
+	std::unordered_map<std::string, symbolState, symbolHash, std::equal_to<>> symbol_table;
+
+	size_t next_shard; //round robin position of front
+	size_t front_shard; //shard of the message front returned
+};
+
+template <typename messageType, size_t capacity>
+shardedFeed<messageType, capacity>::shardedFeed(const SSLContextWrapper& SSL_context_wrapper, const std::string Host, const std::string Port,
+	const socketTransport Transport, const dictionary& Headers, const std::string Path, const time_t Timeout, const std::vector<int>& cores,
+	const formatterType Subscribe_formatter, const formatterType Unsubscribe_formatter, const parserType Parser, const symbolType Symbol_of)
+	: ssl_context_wrapper(const_cast<SSLContextWrapper&>(SSL_context_wrapper)), host(Host), port(Port), path(Path), transport(Transport), headers(Headers),
+	timeout(Timeout), subscribe_formatter(Subscribe_formatter), unsubscribe_formatter(Unsubscribe_formatter), parser(Parser), symbol_of(Symbol_of),
+	next_shard(0), front_shard(0)
+{
+	if (cores.empty()) throw std::runtime_error("A sharded feed needs at least one shard.");
+
+	//every connection generates its own key
+	headers.erase("Sec-Websocket-Key");
+	headers.erase("Sec-WebSocket-Key");
+
+	for (const int core : cores)
+	{
+		std::unique_ptr<shard> new_shard = std::make_unique<shard>();
+
+		//the receivers need non-blocking sockets and skip control frames
+		new_shard->socket = std::make_unique<websocket>(ssl_context_wrapper, host, port, transport, false, false, timeout);
+		new_shard->receiver = std::make_unique<wsReceiver<messageType, capacity>>(*new_shard->socket, parser, core);
+
+		shards.push_back(std::move(new_shard));
+	}
+}
+
+template <typename messageType, size_t capacity>
+shardedFeed<messageType, capacity>::shardedFeed(const shardedFeed& other) : ssl_context_wrapper(other.ssl_context_wrapper)
+{
+	throw std::runtime_error("shardedFeed type doesn't support copy construction.");
+}
+
+template <typename messageType, size_t capacity>
+shardedFeed<messageType, capacity>::~shardedFeed()
+{
+	stop();
+}
+
+template <typename messageType, size_t capacity>
+shardedFeed<messageType, capacity>& shardedFeed<messageType, capacity>::operator=(const shardedFeed& other)
+{
+	throw std::runtime_error("shardedFeed type doesn't support item assignment.");
+}
+
+template <typename messageType, size_t capacity>
+void shardedFeed<messageType, capacity>::connect(shard& target)
+{
+	dictionary upgrade_headers = headers;
+
+	upgrade_headers["Sec-WebSocket-Key"] = generateRandomBase64String(16);
+
+	http::httpResponse response;
+
+	target.socket->reInit();
+	target.socket->open(upgrade_headers, path.c_str(), response);
+
+	if (response.status_code != 101) throw exceptions::exception("Could not open the websocket connection - received status code " + std::to_string(response.status_code) + '.');
+}
+
+template <typename messageType, size_t capacity>
+void shardedFeed<messageType, capacity>::start(const std::vector<std::string>& universe)
+{
+	for (std::unique_ptr<shard>& target : shards) connect(*target);
+
+	std::vector<std::vector<std::string>> assigned(shards.size());
+
+	for (const std::string& symbol : universe)
+	{
+		if (symbol_table.count(symbol)) continue;
+
+		size_t index = symbolHash{}(symbol) % shards.size();
+
+		symbol_table.emplace(symbol, symbolState{ index, 0 });
+		assigned[index].push_back(symbol);
+	}
+
+	//the receivers have not started yet so the connections can be written directly
+	for (size_t index = 0; index < shards.size(); ++index)
+	{
+		if (!assigned[index].empty()) shards[index]->socket->send(subscribe_formatter(assigned[index]), WS_TEXT_FRAME);
+	}
+
+	for (std::unique_ptr<shard>& target : shards) target->receiver->start();
+}
+
+template <typename messageType, size_t capacity>
+void shardedFeed<messageType, capacity>::stop()
+{
+	for (std::unique_ptr<shard>& target : shards)
+	{
+		target->receiver->stop();
+
+		if (target->socket->opened)
+		{
+			try { target->socket->close(); }
+			catch (const std::exception&) {}
+		}
+	}
+}
+
+template <typename messageType, size_t capacity>
+void shardedFeed<messageType, capacity>::send(const size_t index, const std::string& message)
+{
+	if (index >= shards.size()) throw std::runtime_error("Shard " + std::to_string(index) + " does not exist.");
+
+	wsReceiver<messageType, capacity>& target = *shards[index]->receiver;
+
+	//a failed shard is left stopped for restart, which subscribes its symbols again
+	if (target.failed()) return;
+
+	target.send(message, WS_TEXT_FRAME);
+}
+
+template <typename messageType, size_t capacity>
+void shardedFeed<messageType, capacity>::setWaitStrategy(const waitStrategy& strategy)
+{
+	for (const std::unique_ptr<shard>& target : shards) target->socket->setWaitStrategy(strategy);
+}
+
+template <typename messageType, size_t capacity>
+void shardedFeed<messageType, capacity>::subscribe(const std::string& symbol)
+{
+	if (symbol_table.count(symbol)) return;
+
+	size_t index = symbolHash{}(symbol) % shards.size();
+
+	symbol_table.emplace(symbol, symbolState{ index, 0 });
+
+	send(index, subscribe_formatter({ symbol }));
+}
+
+template <typename messageType, size_t capacity>
+void shardedFeed<messageType, capacity>::move(const std::string& symbol, const size_t index)
+{
+	auto entry = symbol_table.find(symbol);
+
+	if (entry == symbol_table.end()) throw std::runtime_error("Can't move " + symbol + " since it was never subscribed to.");
+	if (index >= shards.size()) throw std::runtime_error("Shard " + std::to_string(index) + " does not exist.");
+	if (entry->second.shard == index) return;
+
+	if (reassign(entry->second, index)) send(index, subscribe_formatter({ symbol }));
+}
+
+template <typename messageType, size_t capacity>
+bool shardedFeed<messageType, capacity>::reassign(symbolState& state, const size_t index)
+{
+	auto still_subscribed = std::find(state.leaving.begin(), state.leaving.end(), index);
+	bool subscribe_needed = still_subscribed == state.leaving.end();
+
+	if (!subscribe_needed) state.leaving.erase(still_subscribed);
+
+	state.leaving.push_back(state.shard);
+	state.shard = index;
+
+	return subscribe_needed;
+}
+
+template <typename messageType, size_t capacity>
+size_t shardedFeed<messageType, capacity>::rebalance()
+{
+	std::vector<uint64_t> loads(shards.size(), 0);
+
+	for (const auto& entry : symbol_table) loads[entry.second.shard] += entry.second.count;
+
+	uint64_t total = 0;
+
+	for (const uint64_t shard_load : loads) total += shard_load;
+
+	const double limit = (1.0 + SHARD_UTILS_REBALANCE_TOLERANCE) * total / shards.size();
+
+	//each shard's moves are collected first so every shard gets at most one subscribe message however many symbols move ...
+	//... the old shards are unsubscribed symbol by symbol from pop as each moved symbol shows up on its new shard
+	std::vector<std::vector<std::string>> added(shards.size());
+
+	size_t moved = 0;
+
+	for (size_t attempt = 0; attempt < symbol_table.size(); ++attempt)
+	{
+		size_t busiest = 0;
+		size_t quietest = 0;
+
+		for (size_t index = 1; index < shards.size(); ++index)
+		{
+			if (loads[index] > loads[busiest]) busiest = index;
+			if (loads[index] < loads[quietest]) quietest = index;
+		}
+
+		if (loads[busiest] <= limit) break;
+
+		//the hottest symbol that still leaves the quietest shard below where the busiest one was
+		auto candidate = symbol_table.end();
+
+		for (auto entry = symbol_table.begin(); entry != symbol_table.end(); ++entry)
+		{
+			if (entry->second.shard != busiest || !entry->second.count || entry->second.count >= loads[busiest] - loads[quietest]) continue;
+			if (candidate == symbol_table.end() || entry->second.count > candidate->second.count) candidate = entry;
+		}
+
+		if (candidate == symbol_table.end()) break; //one symbol carries the shard and moving it would only move the problem
+
+		loads[busiest] -= candidate->second.count;
+		loads[quietest] += candidate->second.count;
+
+		if (reassign(candidate->second, quietest)) added[quietest].push_back(candidate->first);
+
+		++moved;
+	}
+
+	for (size_t index = 0; index < shards.size(); ++index) if (!added[index].empty()) send(index, subscribe_formatter(added[index]));
+
+	for (auto& entry : symbol_table) entry.second.count = 0;
+	for (std::unique_ptr<shard>& target : shards) target->load = 0;
+
+	return moved;
+}
+
+template <typename messageType, size_t capacity>
+void shardedFeed<messageType, capacity>::restart(const size_t index)
+{
+	if (index >= shards.size()) throw std::runtime_error("Shard " + std::to_string(index) + " does not exist.");
+
+	shard& target = *shards[index];
+
+	target.receiver->stop();
+
+	//the dead connection is not closed gracefully
+	target.socket->opened = false;
+
+	connect(target);
+
+	//the new connection only carries the shard's own symbols, so there is nothing left to unsubscribe for the symbols leaving it
+	for (auto& entry : symbol_table)
+	{
+		std::vector<size_t>& leaving = entry.second.leaving;
+
+		leaving.erase(std::remove(leaving.begin(), leaving.end(), index), leaving.end());
+	}
+
+	std::vector<std::string> assigned = symbols(index);
+
+	if (!assigned.empty()) target.socket->send(subscribe_formatter(assigned), WS_TEXT_FRAME);
+
+	target.receiver->start();
+}
+
+template <typename messageType, size_t capacity>
+messageType* shardedFeed<messageType, capacity>::front() noexcept
+{
+	for (size_t checked = 0; checked < shards.size(); ++checked)
+	{
+		size_t index = next_shard;
+
+		if (++next_shard == shards.size()) next_shard = 0;
+
+		messageType* message = shards[index]->receiver->front();
+
+		if (message)
+		{
+			front_shard = index;
+
+			return message;
+		}
+	}
+
+	return nullptr;
+}
+
+template <typename messageType, size_t capacity>
+void shardedFeed<messageType, capacity>::pop()
+{
+	shard& source = *shards[front_shard];
+
+	messageType* message = source.receiver->front();
+
+	if (!message) return;
+
+	auto entry = symbol_table.find(symbol_of(*message));
+
+	if (entry != symbol_table.end())
+	{
+		++entry->second.count;
+
+		//the new shard is delivering the symbol, so the shards it moved off can stop
+		if (!entry->second.leaving.empty() && entry->second.shard == front_shard)
+		{
+			for (const size_t index : entry->second.leaving) send(index, unsubscribe_formatter({ entry->first }));
+
+			entry->second.leaving.clear();
+		}
+	}
+
+	++source.load;
+
+	source.receiver->pop();
+}
+
+template <typename messageType, size_t capacity>
+size_t shardedFeed<messageType, capacity>::shard_of(const std::string_view symbol) const
+{
+	auto entry = symbol_table.find(symbol);
+
+	if (entry == symbol_table.end()) throw std::runtime_error("Symbol " + std::string(symbol) + " is not subscribed to.");
+
+	return entry->second.shard;
+}
+
+template <typename messageType, size_t capacity>
+std::vector<std::string> shardedFeed<messageType, capacity>::symbols(const size_t index) const
+{
+	std::vector<std::string> assigned;
+
+	for (const auto& entry : symbol_table) if (entry.second.shard == index) assigned.push_back(entry.first);
+
+	return assigned;
+}
+
+#endif
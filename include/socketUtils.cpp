@@ -1,6 +1,8 @@
 
 #include "socketUtils.h"
 
+#include <chrono>
+
 #ifdef _WIN32
 
 WSAWrapper::WSAWrapper(const WSAWrapper& other)
@@ -25,8 +27,10 @@ WSAWrapper& WSAWrapper::operator=(const WSAWrapper& other)
 
 #endif
 
-inline void closeSocket(socketFD ssl_socket)
+void closeSocket(socketFD& ssl_socket)
 {
+	if (ssl_socket == INVALID_SOCKET) return;
+
 #ifdef _WIN32
 
 	closesocket(ssl_socket);
@@ -36,9 +40,138 @@ inline void closeSocket(socketFD ssl_socket)
 	close(ssl_socket);
 
 #endif
+
+	ssl_socket = INVALID_SOCKET;
+}
+
+inline bool socketWouldBlock() noexcept //true if the last socket call failed only because it would have blocked
+{
+#ifdef _WIN32
+
+	return WSAGetLastError() == WSAEWOULDBLOCK || WSAGetLastError() == WSAETIMEDOUT; //a blocking read that hit SO_RCVTIMEO reports a timeout instead
+
+#else
+
+	return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+#endif
+}
+
+inline bool socketDisconnected() noexcept //true if the last socket call failed because the peer dropped the connection
+{
+#ifdef _WIN32
+
+	return WSAGetLastError() == WSAECONNRESET || WSAGetLastError() == WSAECONNABORTED;
+
+#else
+
+	return errno == ECONNRESET || errno == EPIPE;
+
+#endif
+}
+
+int64_t realtimeNanoseconds() noexcept
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 }
 
-void socketCleanup(SSL*& ssl_struct, socketFD ssl_socket)
+#if SOCKET_UTILS_RECV_TIMESTAMPS
+
+/*
+read from the socket with recvmsg so that the SCM_TIMESTAMPNS control message can be collected
+the timestamp belongs to the last packet that was copied into the buffer
+*/
+int timestampedRecv(SSLSocket& ssl_socket, char* buffer, int buffer_size)
+{
+	char control[CMSG_SPACE(sizeof(timespec))];
+
+	iovec io_vector{ buffer, static_cast<size_t>(buffer_size) };
+	msghdr message_header{};
+
+	message_header.msg_iov = &io_vector;
+	message_header.msg_iovlen = 1;
+	message_header.msg_control = control;
+	message_header.msg_controllen = sizeof(control);
+
+	int bytes = recvmsg(ssl_socket.ssl_socket, &message_header, 0);
+
+	if (bytes <= 0) return bytes;
+
+	for (cmsghdr* control_message = CMSG_FIRSTHDR(&message_header); control_message; control_message = CMSG_NXTHDR(&message_header, control_message))
+	{
+		if (control_message->cmsg_level == SOL_SOCKET && control_message->cmsg_type == SCM_TIMESTAMPNS)
+		{
+			timespec kernel_time;
+
+			memcpy(&kernel_time, CMSG_DATA(control_message), sizeof(kernel_time));
+
+			ssl_socket.kernel_recv_ns = kernel_time.tv_sec * 1000000000LL + kernel_time.tv_nsec;
+		}
+	}
+
+	return bytes;
+}
+
+//a minimal socket BIO for openssl that reads through timestampedRecv instead of recv
+static int timestampBioWrite(BIO* bio, const char* buffer, int buffer_size)
+{
+	BIO_clear_retry_flags(bio);
+
+	int bytes = send(static_cast<SSLSocket*>(BIO_get_data(bio))->get_fd(), buffer, buffer_size, SOCKET_UTILS_SEND_FLAGS);
+
+	if (bytes < 0 && socketWouldBlock()) BIO_set_retry_write(bio);
+
+	return bytes;
+}
+
+static int timestampBioRead(BIO* bio, char* buffer, int buffer_size)
+{
+	BIO_clear_retry_flags(bio);
+
+	int bytes = timestampedRecv(*static_cast<SSLSocket*>(BIO_get_data(bio)), buffer, buffer_size);
+
+	if (bytes < 0 && socketWouldBlock()) BIO_set_retry_read(bio);
+
+	return bytes;
+}
+
+static long timestampBioCtrl(BIO*, int command, long, void*)
+{
+	if (command == BIO_CTRL_FLUSH) return 1; //writes are unbuffered
+
+	return 0;
+}
+
+static int timestampBioCreate(BIO* bio)
+{
+	BIO_set_init(bio, 1);
+
+	return 1;
+}
+
+static BIO_METHOD* timestampBioMethod()
+{
+	//created once and shared by every socket - openssl never frees it before the program exits
+	static BIO_METHOD* bio_method = []
+	{
+		BIO_METHOD* method = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK | BIO_TYPE_DESCRIPTOR, "timestamped socket");
+
+		if (!method) throw std::runtime_error("Timestamping BIO method creation failed.");
+
+		BIO_meth_set_write(method, timestampBioWrite);
+		BIO_meth_set_read(method, timestampBioRead);
+		BIO_meth_set_ctrl(method, timestampBioCtrl);
+		BIO_meth_set_create(method, timestampBioCreate);
+
+		return method;
+	}();
+
+	return bio_method;
+}
+
+#endif
+
+void socketCleanup(SSL*& ssl_struct, socketFD& ssl_socket)
 {
 	if (ssl_struct)
 	{
@@ -137,72 +270,178 @@ SSL_CTX* SSLContextWrapper::get_context() const noexcept
 
 void socketInit(SSLSocket& ssl_socket)
 {
-	addrinfo hints{};
-	addrinfo* result = nullptr;
+	int64_t start_ns = steadyNanoseconds();
+
+	if (ssl_socket.transport == socketTransport::UNIX)
+	{
 
-	hints.ai_family = PF_UNSPEC;
-	hints.ai_socktype = SOCK_STREAM;
+#ifdef _WIN32
+
+		throw exceptions::exception("Unix domain sockets are not supported on this platform.");
+
+#else
 
-	//Resolve the hostname
-	if (getaddrinfo(ssl_socket.host.c_str(), "443", &hints, &result))
+		sockaddr_un address{};
+
+		if (ssl_socket.host.size() >= sizeof(address.sun_path)) throw exceptions::exception("Unix domain socket path is too long : " + ssl_socket.host);
+
+		address.sun_family = AF_UNIX;
+
+		memcpy(address.sun_path, ssl_socket.host.c_str(), ssl_socket.host.size() + 1);
+
+		ssl_socket.ssl_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+
+		if (ssl_socket.ssl_socket == INVALID_SOCKET) throw exceptions::exception("Unix domain socket creation failed.");
+		if (connect(ssl_socket.ssl_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1)
+		{
+			closeSocket(ssl_socket.ssl_socket);
+
+			throw exceptions::exception("Could not connect to " + ssl_socket.host + '.');
+		}
+
+		memcpy(ssl_socket.ip_address, "unix", 5);
+
+#endif
+
+	}
+	else
 	{
+		addrinfo hints{};
+		addrinfo* result = nullptr;
+
+		hints.ai_family = PF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+
+		//Resolve the hostname
+		if (getaddrinfo(ssl_socket.host.c_str(), ssl_socket.port.c_str(), &hints, &result))
+		{
+			freeaddrinfo(result);
+
+			throw exceptions::exception("Failed to resolve hostname.");
+		}
+
+		bool connected = false;
+
+		for (addrinfo* next_addr = result; next_addr != nullptr; next_addr = next_addr->ai_next)
+		{
+			ssl_socket.ssl_socket = socket(next_addr->ai_family, next_addr->ai_socktype, next_addr->ai_protocol);
+
+			if (ssl_socket.ssl_socket == INVALID_SOCKET) continue; //socket creation failed
+			if (connect(ssl_socket.ssl_socket, next_addr->ai_addr, next_addr->ai_addrlen) == -1) //could not connect to ssl_socket.host
+			{
+				closeSocket(ssl_socket.ssl_socket);
+
+				continue;
+			}
+
+			//record the ip address for debugging purposes
+			inet_ntop(next_addr->ai_family, &((struct sockaddr_in*)next_addr->ai_addr)->sin_addr, ssl_socket.ip_address, sizeof(ssl_socket.ip_address));
+
+			connected = true; //we were able to connect to a host
+
+			break;
+		}
+
 		freeaddrinfo(result);
 
-		throw exceptions::exception("Failed to resolve hostname.");
+		if (!connected) throw exceptions::exception("Either : socket creation failed, or could not connect to " + ssl_socket.host + '.');
 	}
 
-	bool connected = false;
+	ssl_socket.stats.connect_ns.set(steadyNanoseconds() - start_ns);
+
+	ssl_socket.alpn_selected.clear();
 
-	for (addrinfo* next_addr = result; next_addr != nullptr; next_addr = next_addr->ai_next)
+	if (ssl_socket.transport == socketTransport::TLS)
 	{
-		ssl_socket.ssl_socket = socket(next_addr->ai_family, next_addr->ai_socktype, next_addr->ai_protocol);
+		ssl_socket.ssl_struct = SSL_new(ssl_socket.ssl_context_wrapper.get_context());
 
-		if (ssl_socket.ssl_socket == INVALID_SOCKET) continue; //socket creation failed
-		if (connect(ssl_socket.ssl_socket, next_addr->ai_addr, next_addr->ai_addrlen) == -1) //could not connect to ssl_socket.host
+		if (!ssl_socket.ssl_struct)
 		{
 			closeSocket(ssl_socket.ssl_socket);
 
-			continue;
+			throw std::runtime_error("SSL structure creation failed.");
 		}
 
-		//record the ip address for debugging purposes
-		inet_ntop(next_addr->ai_family, &((struct sockaddr_in*)next_addr->ai_addr)->sin_addr, ssl_socket.ip_address, sizeof(ssl_socket.ip_address));
+#if SOCKET_UTILS_RECV_TIMESTAMPS
 
-		connected = true; //we were able to connect to a host
+		if (ssl_socket.recv_timestamps)
+		{
+			int enable = 1;
 
-		break;
-	}
+			BIO* bio = BIO_new(timestampBioMethod());
 
-	freeaddrinfo(result);
+			if (!bio || setsockopt(ssl_socket.ssl_socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) != 0)
+			{
+				if (bio) BIO_free(bio);
 
-	if (!connected) throw exceptions::exception("Either : socket creation failed, or could not connect to " + ssl_socket.host + '.');
+				socketCleanup(ssl_socket.ssl_struct, ssl_socket.ssl_socket);
 
-	ssl_socket.ssl_struct = SSL_new(ssl_socket.ssl_context_wrapper.get_context());
+				throw std::runtime_error("Could not enable receive timestamps.");
+			}
 
-	if (!ssl_socket.ssl_struct)
-	{
-		closeSocket(ssl_socket.ssl_socket);
+			BIO_set_data(bio, &ssl_socket);
+			SSL_set_bio(ssl_socket.ssl_struct, bio, bio); //the ssl structure takes ownership of the BIO
+		}
+		else SSL_set_fd(ssl_socket.ssl_struct, ssl_socket.ssl_socket);
 
-		throw std::runtime_error("SSL structure creation failed.");
-	}
+#else
 
-	SSL_set_fd(ssl_socket.ssl_struct, ssl_socket.ssl_socket);
+		SSL_set_fd(ssl_socket.ssl_struct, ssl_socket.ssl_socket);
 
-	//Server Name Indication (SNI) is needed for alpaca since alpaca has multiple domain names
-	if (SSL_set_tlsext_host_name(ssl_socket.ssl_struct, ssl_socket.host.c_str()) != 1)
-	{
-		socketCleanup(ssl_socket.ssl_struct, ssl_socket.ssl_socket);
+#endif
+
+		//Server Name Indication (SNI) is needed for alpaca since alpaca has multiple domain names
+		if (SSL_set_tlsext_host_name(ssl_socket.ssl_struct, ssl_socket.host.c_str()) != 1)
+		{
+			socketCleanup(ssl_socket.ssl_struct, ssl_socket.ssl_socket);
+
+			throw exceptions::exception("SNI failed for " + ssl_socket.host);
+		}
+
+		//SSL_set_alpn_protos returns 0 on success unlike the other ssl functions
+		if (!ssl_socket.alpn_protocols.empty() && SSL_set_alpn_protos(ssl_socket.ssl_struct, reinterpret_cast<const unsigned char*>(ssl_socket.alpn_protocols.data()),
+			static_cast<unsigned int>(ssl_socket.alpn_protocols.size())) != 0)
+		{
+			socketCleanup(ssl_socket.ssl_struct, ssl_socket.ssl_socket);
+
+			throw exceptions::exception("Could not offer application protocols to " + ssl_socket.host);
+		}
+
+		start_ns = steadyNanoseconds();
+
+		if (SSL_connect(ssl_socket.ssl_struct) != 1)
+		{
+			socketCleanup(ssl_socket.ssl_struct, ssl_socket.ssl_socket);
+
+			throw exceptions::exception("SSL handshake failed for " + ssl_socket.host);
+		}
+
+		ssl_socket.stats.handshake_ns.set(steadyNanoseconds() - start_ns);
 
-		throw exceptions::exception("SNI failed for " + ssl_socket.host);
+		const unsigned char* selected = nullptr;
+		unsigned int selected_length = 0;
+
+		SSL_get0_alpn_selected(ssl_socket.ssl_struct, &selected, &selected_length);
+
+		if (selected) ssl_socket.alpn_selected.assign(reinterpret_cast<const char*>(selected), selected_length);
 	}
 
-	if (SSL_connect(ssl_socket.ssl_struct) != 1)
+#if SOCKET_UTILS_RECV_TIMESTAMPS
+
+	else if (ssl_socket.recv_timestamps)
 	{
-		socketCleanup(ssl_socket.ssl_struct, ssl_socket.ssl_socket);
+		int enable = 1;
+
+		if (setsockopt(ssl_socket.ssl_socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) != 0)
+		{
+			socketCleanup(ssl_socket.ssl_struct, ssl_socket.ssl_socket);
 
-		throw exceptions::exception("SSL handshake failed for " + ssl_socket.host);
+			throw std::runtime_error("Could not enable receive timestamps.");
+		}
 	}
 
+#endif
+
 	//set the socket to non-blocking
 	if (!ssl_socket.blocking)
 	{
@@ -222,15 +461,32 @@ void socketInit(SSLSocket& ssl_socket)
 
 		fcntl(ssl_socket.ssl_socket, F_SETFL, socket_flags | O_NONBLOCK);
 #endif
-		SSL_set_mode(ssl_socket.ssl_struct, SSL_MODE_AUTO_RETRY);
+		if (ssl_socket.ssl_struct) SSL_set_mode(ssl_socket.ssl_struct, SSL_MODE_AUTO_RETRY);
 	}
 }
 
+//the value of the Host header - the port is left out when it is the default one for the transport
+std::string hostHeader(const std::string& host, const std::string& port, const socketTransport transport)
+{
+	if (transport == socketTransport::UNIX) return "localhost";
+	if (transport == socketTransport::TLS && port == "443") return host;
+	if (transport == socketTransport::TCP && port == "80") return host;
+
+	return host + ':' + port;
+}
+
 SSLSocket::SSLSocket(const SSLSocket& other_socket)
-	: ssl_context_wrapper(const_cast<SSLContextWrapper&>(other_socket.ssl_context_wrapper)), host(other_socket.host), blocking(other_socket.blocking), ssl_struct(nullptr) {}
+	: ssl_struct(nullptr), ssl_socket(INVALID_SOCKET), host(other_socket.host), port(other_socket.port), host_header(other_socket.host_header), transport(other_socket.transport),
+	blocking(other_socket.blocking), recv_timestamps(other_socket.recv_timestamps), alpn_protocols(other_socket.alpn_protocols), wait_strategy(other_socket.wait_strategy),
+	ssl_context_wrapper(const_cast<SSLContextWrapper&>(other_socket.ssl_context_wrapper)) {}
 
 SSLSocket::SSLSocket(const SSLContextWrapper& SSL_context_wrapper, const std::string Host, const bool Blocking) //assumes port = 443
-	: ssl_context_wrapper(const_cast<SSLContextWrapper&>(SSL_context_wrapper)), host(Host), blocking(Blocking), ssl_struct(nullptr) {}
+	: ssl_struct(nullptr), ssl_socket(INVALID_SOCKET), host(Host), port("443"), host_header(Host), transport(socketTransport::TLS), blocking(Blocking),
+	ssl_context_wrapper(const_cast<SSLContextWrapper&>(SSL_context_wrapper)) {}
+
+SSLSocket::SSLSocket(const SSLContextWrapper& SSL_context_wrapper, const std::string Host, const std::string Port, const socketTransport Transport, const bool Blocking)
+	: ssl_struct(nullptr), ssl_socket(INVALID_SOCKET), host(Host), port(Port), host_header(hostHeader(Host, Port, Transport)), transport(Transport), blocking(Blocking),
+	ssl_context_wrapper(const_cast<SSLContextWrapper&>(SSL_context_wrapper)) {}
 
 SSLSocket::~SSLSocket()
 {
@@ -244,6 +500,8 @@ SSLSocket& SSLSocket::operator=(const SSLSocket& other_socket)
 
 void SSLSocket::reInit()
 {
+	if (ssl_socket != INVALID_SOCKET) stats.reconnects.add(1);
+
 	socketCleanup(ssl_struct, ssl_socket);
 	socketInit(*this);
 }
@@ -253,16 +511,189 @@ void SSLSocket::writeIpAddrToString(std::string& ip_addr)
 	ip_addr.assign(ip_address);
 }
 
+void SSLSocket::setRecvTimestamps(const bool enable)
+{
+	recv_timestamps = enable && SOCKET_UTILS_RECV_TIMESTAMPS;
+}
+
+void SSLSocket::setReadTimeout(const int timeout_ms)
+{
+	if (ssl_socket == INVALID_SOCKET) return;
+
+#ifdef _WIN32
+
+	DWORD timeout = static_cast<DWORD>(timeout_ms);
+
+#else
+
+	timeval timeout{ timeout_ms / 1000, (timeout_ms % 1000) * 1000 };
+
+#endif
+
+	if (setsockopt(ssl_socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout)) != 0)
+	{
+		throw exceptions::exception("Could not set the socket read timeout.");
+	}
+}
+
 SSL* SSLSocket::get_struct() const noexcept
 {
 	return ssl_struct;
 }
 
+socketFD SSLSocket::get_fd() const noexcept
+{
+	return ssl_socket;
+}
+
+socketTransport SSLSocket::get_transport() const noexcept
+{
+	return transport;
+}
+
+bool SSLSocket::is_blocking() const noexcept
+{
+	return blocking;
+}
+
+bool SSLSocket::is_connected() const noexcept
+{
+	return ssl_socket != INVALID_SOCKET;
+}
+
+bool SSLSocket::is_alive()
+{
+	if (ssl_socket == INVALID_SOCKET) return false;
+
+	//an idle connection should have nothing to read - if it is readable then the peer either closed it or sent a close_notify alert
+	//unread data on an idle connection also means the stream is out of sync
+	return !wait_readable(0);
+}
+
+bool SSLSocket::wait_readable(const int timeout_ms)
+{
+	if (ssl_struct && SSL_pending(ssl_struct) > 0) return true; //already decrypted and buffered by openssl
+
+	pollfd descriptor{};
+
+	descriptor.fd = ssl_socket;
+	descriptor.events = POLLIN;
+
+#ifdef _WIN32
+
+	return WSAPoll(&descriptor, 1, timeout_ms) > 0;
+
+#else
+
+	return poll(&descriptor, 1, timeout_ms) > 0;
+
+#endif
+}
+
+void SSLSocket::setAlpnProtocols(const std::vector<std::string>& protocols)
+{
+	alpn_protocols.clear();
+
+	for (const std::string& protocol : protocols)
+	{
+		if (protocol.empty() || protocol.size() > 255) throw std::runtime_error("Application protocol names must be 1 to 255 bytes long.");
+
+		alpn_protocols.push_back(static_cast<char>(protocol.size()));
+		alpn_protocols.append(protocol);
+	}
+}
+
+const std::string& SSLSocket::get_alpn() const noexcept
+{
+	return alpn_selected;
+}
+
+void SSLSocket::setWaitStrategy(const waitStrategy& strategy)
+{
+	wait_strategy = strategy;
+}
+
+const waitStrategy& SSLSocket::get_wait_strategy() const noexcept
+{
+	return wait_strategy;
+}
+
+void SSLSocket::idle()
+{
+	if (blocking) return; //the read already waited
+
+	switch (wait_strategy.next())
+	{
+		case waitPhase::SPIN: stats.idle_spins.add(1); break;
+		case waitPhase::PAUSE: stats.idle_pauses.add(1); break;
+		case waitPhase::BLOCK:
+		{
+			stats.idle_blocks.add(1);
+			wait_readable(wait_strategy.block_ms());
+
+			break;
+		}
+	}
+}
+
+const std::string& SSLSocket::get_host_header() const noexcept
+{
+	return host_header;
+}
+
+const socketStats& SSLSocket::get_stats() const noexcept
+{
+	return stats;
+}
+
+socketStats& SSLSocket::get_stats() noexcept
+{
+	return stats;
+}
+
+int64_t SSLSocket::get_kernel_recv_ns() const noexcept
+{
+	return kernel_recv_ns;
+}
+
+int64_t SSLSocket::get_user_recv_ns() const noexcept
+{
+	return user_recv_ns;
+}
+
 int SSLSocket::read(void* buffer, const int buffer_size)
 {
-	bytes_read = SSL_read(ssl_struct, buffer, buffer_size);
+	stats.read_calls.add(1);
+
+	if (transport == socketTransport::TLS) bytes_read = SSL_read(ssl_struct, buffer, buffer_size);
+
+#if SOCKET_UTILS_RECV_TIMESTAMPS
+
+	else if (recv_timestamps) bytes_read = timestampedRecv(*this, static_cast<char*>(buffer), buffer_size);
+
+#endif
+
+	else bytes_read = recv(ssl_socket, static_cast<char*>(buffer), buffer_size, 0);
 
-	if (bytes_read > 0) return bytes_read;
+	if (bytes_read > 0)
+	{
+		stats.bytes_read.add(bytes_read);
+		wait_strategy.reset();
+
+		if (recv_timestamps) user_recv_ns = realtimeNanoseconds();
+
+		return bytes_read;
+	}
+
+	if (transport != socketTransport::TLS)
+	{
+		if (bytes_read == 0 || socketDisconnected()) throw SSLNoReturn("Connection closed by the peer on read.");
+		if (!socketWouldBlock()) throw exceptions::exception(std::string("Socket error occured when reading - error no. ") + std::to_string(errno));
+
+		stats.want_read.add(1);
+
+		return 0;
+	}
 
 	error_read = SSL_get_error(ssl_struct, bytes_read);
 
@@ -275,14 +706,128 @@ int SSLSocket::read(void* buffer, const int buffer_size)
 			std::string(" with error no. ") + std::to_string(ssl_error));
 	}
 
+	stats.want_read.add(1);
+
 	return 0;
 }
 
 int SSLSocket::write(const std::string& message)
 {
-	bytes_write = SSL_write(ssl_struct, message.c_str(), message.size());
+	return write(message.data(), static_cast<int>(message.size()));
+}
+
+int SSLSocket::write(const void* data, const int length)
+{
+	stats.write_calls.add(1);
+
+	if (transport == socketTransport::TLS) bytes_write = SSL_write(ssl_struct, data, length);
+	else bytes_write = send(ssl_socket, static_cast<const char*>(data), length, SOCKET_UTILS_SEND_FLAGS);
+
+	return writeResult();
+}
+
+int SSLSocket::write(const writeSpan* spans, const size_t span_count, const size_t offset)
+{
+	size_t skipped = 0;
+	size_t first = 0;
+
+	//find the span that contains offset
+	while (first < span_count && skipped + spans[first].length <= offset) skipped += spans[first++].length;
+
+	if (first >= span_count) return 0; //nothing left to write
+
+	const char* first_data = spans[first].data + (offset - skipped);
+	size_t first_length = spans[first].length - (offset - skipped);
+
+	size_t last = first + 1;
+
+	while (last < span_count && spans[last].length == 0) last++;
+
+	//a single remaining span needs no gathering
+	if (last >= span_count) return write(first_data, static_cast<int>(first_length));
+
+	stats.write_calls.add(1);
+
+	if (transport == socketTransport::TLS)
+	{
+		//the same spans and offset always produce the same buffer contents so retrying after SSL_ERROR_WANT_WRITE is safe
+		size_t buffered = first_length < SOCKET_UTILS_WRITE_BUFFER_SIZE ? first_length : SOCKET_UTILS_WRITE_BUFFER_SIZE;
+
+		memcpy(write_buffer, first_data, buffered);
+
+		for (size_t index = first + 1; index < span_count && buffered < SOCKET_UTILS_WRITE_BUFFER_SIZE; ++index)
+		{
+			size_t length = spans[index].length < SOCKET_UTILS_WRITE_BUFFER_SIZE - buffered ? spans[index].length : SOCKET_UTILS_WRITE_BUFFER_SIZE - buffered;
+
+			memcpy(write_buffer + buffered, spans[index].data, length);
+
+			buffered += length;
+		}
+
+		bytes_write = SSL_write(ssl_struct, write_buffer, static_cast<int>(buffered));
+
+		return writeResult();
+	}
+
+#ifdef _WIN32
+
+	WSABUF buffers[SOCKET_UTILS_MAX_WRITE_SPANS];
+	DWORD buffer_count = 1;
+	DWORD sent = 0;
+
+	buffers[0].buf = const_cast<char*>(first_data);
+	buffers[0].len = static_cast<ULONG>(first_length);
+
+	for (size_t index = first + 1; index < span_count && buffer_count < SOCKET_UTILS_MAX_WRITE_SPANS; ++index)
+	{
+		buffers[buffer_count].buf = const_cast<char*>(spans[index].data);
+		buffers[buffer_count++].len = static_cast<ULONG>(spans[index].length);
+	}
+
+	bytes_write = WSASend(ssl_socket, buffers, buffer_count, &sent, 0, nullptr, nullptr) == 0 ? static_cast<int>(sent) : -1;
+
+#else
+
+	iovec buffers[SOCKET_UTILS_MAX_WRITE_SPANS];
+	msghdr message_header{};
+
+	buffers[0].iov_base = const_cast<char*>(first_data);
+	buffers[0].iov_len = first_length;
+
+	message_header.msg_iov = buffers;
+	message_header.msg_iovlen = 1;
+
+	for (size_t index = first + 1; index < span_count && message_header.msg_iovlen < SOCKET_UTILS_MAX_WRITE_SPANS; ++index)
+	{
+		buffers[message_header.msg_iovlen].iov_base = const_cast<char*>(spans[index].data);
+		buffers[message_header.msg_iovlen++].iov_len = spans[index].length;
+	}
+
+	bytes_write = static_cast<int>(sendmsg(ssl_socket, &message_header, SOCKET_UTILS_SEND_FLAGS));
+
+#endif
+
+	return writeResult();
+}
+
+int SSLSocket::writeResult()
+{
+	if (bytes_write > 0)
+	{
+		stats.bytes_written.add(bytes_write);
+
+		return bytes_write;
+	}
+
+	if (transport != socketTransport::TLS)
+	{
+		if (socketDisconnected()) throw SSLNoReturn("Connection closed by the peer on write.");
+		if (bytes_write < 0 && !socketWouldBlock()) throw exceptions::exception(std::string("Socket error occured when writing - error no. ") + std::to_string(errno));
 
-	if (bytes_write > 0) return bytes_write;
+		stats.want_write.add(1);
+
+		return 0;
+	}
 
 	error_write = SSL_get_error(ssl_struct, bytes_write);
 
@@ -297,5 +842,7 @@ int SSLSocket::write(const std::string& message)
 			std::string(" with error no. ") + std::to_string(ssl_error));
 	}
 
+	stats.want_write.add(1);
+
 	return 0;
-}
+}
\ No newline at end of file
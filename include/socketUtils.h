@@ -5,9 +5,13 @@
 #define SOCKET_UTILS_H
 
 #include "exceptUtils.h"
+#include "statUtils.h"
+#include "waitUtils.h"
 
 #include <string>
 #include <stdexcept>
+#include <cstdint>
+#include <vector>
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 
@@ -15,6 +19,8 @@
 #pragma comment(lib, "libcrypto.lib")
 
 #define SOCKET_UTILS_MAX_SHUTDOWN_ATTEMPTS 2
+#define SOCKET_UTILS_WRITE_BUFFER_SIZE 16384 //the largest tls record - gathered writes over tls are coalesced into one record at a time
+#define SOCKET_UTILS_MAX_WRITE_SPANS 16
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -32,12 +38,32 @@ using socketFD = SOCKET; //type definition for the file descriptor type on windo
 #include <unistd.h> //for the close() function
 #include <netdb.h>
 #include <fcntl.h>
+#include <sys/un.h> //for unix domain sockets
+#include <poll.h>
+#include <cerrno>
+#include <cstring>
 
 using socketFD = int; //type definition for the file descriptor type on non-windows
 const int INVALID_SOCKET = -1; //already defined on windows
 
 #endif
 
+#ifdef MSG_NOSIGNAL
+#define SOCKET_UTILS_SEND_FLAGS MSG_NOSIGNAL //report a closed connection as an error instead of raising SIGPIPE
+#else
+#define SOCKET_UTILS_SEND_FLAGS 0
+#endif
+
+//kernel software receive timestamps are only available where SO_TIMESTAMPNS is (linux)
+#if defined(SO_TIMESTAMPNS) && !defined(_WIN32)
+#define SOCKET_UTILS_RECV_TIMESTAMPS 1
+#else
+#define SOCKET_UTILS_RECV_TIMESTAMPS 0
+#endif
+
+//nanoseconds since the epoch from the realtime clock - the same clock the kernel uses for SO_TIMESTAMPNS
+int64_t realtimeNanoseconds() noexcept;
+
 /*
 Instructions to configure openssl in VS 2022:
 1) get openssl directly from this page - https://slproweb.com/products/Win32OpenSSL.html
@@ -81,7 +107,28 @@ private:
 
 #endif
 
-void socketCleanup(SSL*&, socketFD);
+//a contiguous piece of an outgoing message for gathered writes
+struct writeSpan
+{
+	const char* data;
+	size_t length;
+};
+
+void closeSocket(socketFD&); //closes the socket once and invalidates the descriptor
+void socketCleanup(SSL*&, socketFD&); //shuts down the ssl structure (if there is one) and closes the socket
+
+/*
+how an SSLSocket talks to its peer
+TLS is what every real endpoint needs - TCP and UNIX are plaintext and exist to benchmark the websocket and http modules against a local server
+*/
+enum class socketTransport
+{
+	TLS,  //tls over tcp (default)
+	TCP,  //plaintext tcp
+	UNIX  //plaintext unix domain socket - the host is the path of the socket file
+};
+
+std::string hostHeader(const std::string&, const std::string&, const socketTransport); //value of the Host header for a host, port, and transport
 
 class SSLContextWrapper //you need to make sure that this object outlives all sockets in your program
 {
@@ -103,7 +150,8 @@ class SSLSocket
 {
 public:
 	SSLSocket(const SSLSocket&);
-	SSLSocket(const SSLContextWrapper&, const std::string, bool);
+	SSLSocket(const SSLContextWrapper&, const std::string, bool); //tls on port 443
+	SSLSocket(const SSLContextWrapper&, const std::string, const std::string, const socketTransport, const bool); //host, port, transport, blocking
 	~SSLSocket();
 
 	SSLSocket& operator=(const SSLSocket&); //I have this to make sure that I am only using the copy constructor
@@ -111,27 +159,99 @@ public:
 	void reInit(); //initialize or reinitialize the socket
 	void writeIpAddrToString(std::string&); //write the recorded ip address to a string
 
-	SSL* get_struct() const noexcept;
+	/*
+	enable SO_TIMESTAMPNS (kernel software receive timestamps) - takes effect on the next call to reInit
+	when enabled, every read records the kernel timestamp of the last packet pulled off the socket and the time the read returned
+	does nothing on platforms without SO_TIMESTAMPNS
+	*/
+	void setRecvTimestamps(const bool);
+
+	/*
+	make blocking reads give up after the given milliseconds (0 waits forever) - a read that times out returns 0 like a non-blocking one
+	applies to the connected socket only, so it has to be called again after reInit
+	*/
+	void setReadTimeout(const int);
+
+	/*
+	offer these application protocols (ALPN) in the tls handshake, most preferred first - takes effect on the next call to reInit
+	kept on the socket rather than the context so http/1.1 clients and websockets sharing the context never negotiate h2 by accident
+	*/
+	void setAlpnProtocols(const std::vector<std::string>&);
+	const std::string& get_alpn() const noexcept; //the protocol the server picked in the last handshake (empty if none or not tls)
+
+	SSL* get_struct() const noexcept; //nullptr for plaintext transports
+	socketFD get_fd() const noexcept;
+	socketTransport get_transport() const noexcept;
+	bool is_blocking() const noexcept;
+
+	bool is_connected() const noexcept;
+	bool is_alive(); //true if an idle connection is still open and has no unread data - does not block
+	bool wait_readable(const int); //true if a read would return data (or report a closed connection) - waits up to the given milliseconds (0 = don't wait)
+
+	/*
+	how a non-blocking reader waits between empty reads (see waitStrategy) - kept across reInit
+	idle is called after a read returned nothing and spins, pauses, or blocks in poll as the strategy says - it does nothing on blocking sockets
+	*/
+	void setWaitStrategy(const waitStrategy&);
+	const waitStrategy& get_wait_strategy() const noexcept;
+	void idle();
+
+	const std::string& get_host_header() const noexcept; //host (and port if it isn't the default one) to send in the Host header
+
+	const socketStats& get_stats() const noexcept; //safe to read from a monitoring thread
+	socketStats& get_stats() noexcept;
+
+	int64_t get_kernel_recv_ns() const noexcept; //kernel timestamp of the packet that delivered the last read (0 if unavailable)
+	int64_t get_user_recv_ns() const noexcept; //realtime clock when the last read that returned data completed (0 if timestamps are disabled)
 
 	int read(void* buffer, const int buffer_size); //could be virtual
 	int write(const std::string& message); //could be virtual
+	int write(const void* data, const int length); //write from memory the caller owns - resume a partial write by advancing data by the bytes returned
+
+	/*
+	write a message made of several spans without joining them first - returns the number of bytes written starting at offset
+	resume a partial write by calling again with the same spans and offset advanced by the bytes returned
+	plaintext transports hand the spans straight to the kernel
+	tls copies up to one record at a time into a buffer owned by the socket unless the remaining data is a single span
+	*/
+	int write(const writeSpan* spans, const size_t span_count, const size_t offset);
 
 protected:
 	SSL* ssl_struct;
 	socketFD ssl_socket;
 
 	std::string host;
+	std::string port;
+	std::string host_header;
+
+	socketTransport transport;
 
 private:
 	friend void socketInit(SSLSocket&); //this shouldn't be accessable outside the class
+	friend int timestampedRecv(SSLSocket&, char*, int); //used by the timestamping BIO
 
 	int bytes_read = 0;
 	int bytes_write = 0;
 
+	int writeResult(); //shared error handling for the write functions - returns bytes_write or 0 if the write would block
+
 	int error_read = 0; //ssl error code on read
 	int error_write = 0; //ssl error code on write
 
 	bool blocking; //true if the socket is a blocking socket
+	bool recv_timestamps = false; //true if SO_TIMESTAMPNS should be enabled on the socket
+
+	int64_t kernel_recv_ns = 0;
+	int64_t user_recv_ns = 0;
+
+	std::string alpn_protocols; //length prefixed protocol names as sent in the handshake
+	std::string alpn_selected;
+
+	socketStats stats;
+
+	waitStrategy wait_strategy;
+
+	char write_buffer[SOCKET_UTILS_WRITE_BUFFER_SIZE]; //coalesces gathered tls writes
 	
 	char ip_address[INET6_ADDRSTRLEN] = ""; //record ip address for debugging
 
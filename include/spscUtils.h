@@ -0,0 +1,165 @@
+
+//lock-free bounded queue for handing elements from one producer thread to one consumer thread
+
+#ifndef SPSC_UTILS_H
+#define SPSC_UTILS_H
+
+#define SPSC_UTILS_CACHE_LINE 64
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+/*
+A fixed capacity ring of preallocated elements shared by exactly one producer thread and exactly one consumer thread
+The read and write positions live on separate cache lines and each side keeps a cached copy of the other side's position ...
+... so the shared lines are only touched when the cached copy says the queue looks full (producer) or empty (consumer)
+Elements are never destroyed or reallocated - write_slot and front hand out references to the slots themselves so a slot's ...
+... buffers (a std::string's capacity, for example) are reused instead of allocated for every element
+capacity must be a power of two
+*/
+
+template <typename dataType, size_t capacity>
+class spscQueue
+{
+public:
+    static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "spscQueue capacity must be a power of two.");
+
+    spscQueue();
+    spscQueue(const spscQueue&);
+    ~spscQueue();
+
+    //producer side
+    inline dataType* write_slot() noexcept; //the next free slot or nullptr if the queue is full - fill it in and then call publish
+    inline void publish() noexcept; //make the slot returned by write_slot visible to the consumer
+    inline bool try_push(const dataType&); //copy an element in - false if the queue is full
+
+    //consumer side
+    inline dataType* front() noexcept; //the oldest published element or nullptr if the queue is empty
+    inline void pop() noexcept; //release the element returned by front back to the producer
+    inline bool try_pop(dataType&); //swap the oldest element out - false if the queue is empty
+
+    inline size_t size() const noexcept; //number of published elements - exact on either side and approximate from any other thread
+    constexpr inline size_t max_size() const noexcept { return capacity; }
+
+    spscQueue& operator=(const spscQueue&);
+
+private:
+    static constexpr size_t index_mask = capacity - 1;
+
+    alignas(SPSC_UTILS_CACHE_LINE) std::atomic<size_t> head; //next element to read - only written by the consumer
+    size_t cached_tail; //the consumer's last view of tail
+
+    alignas(SPSC_UTILS_CACHE_LINE) std::atomic<size_t> tail; //next slot to write - only written by the producer
+    size_t cached_head; //the producer's last view of head
+
+    alignas(SPSC_UTILS_CACHE_LINE) dataType* slots;
+};
+
+template <typename dataType, size_t capacity>
+spscQueue<dataType, capacity>::spscQueue() : head(0), cached_tail(0), tail(0), cached_head(0)
+{
+    slots = new dataType[capacity];
+}
+
+template <typename dataType, size_t capacity>
+spscQueue<dataType, capacity>::spscQueue(const spscQueue& other)
+{
+    throw std::runtime_error("spscQueue type doesn't support copy construction.");
+}
+
+template <typename dataType, size_t capacity>
+spscQueue<dataType, capacity>::~spscQueue()
+{
+    delete[] slots;
+
+    slots = nullptr;
+}
+
+template <typename dataType, size_t capacity>
+inline dataType* spscQueue<dataType, capacity>::write_slot() noexcept
+{
+    size_t position = tail.load(std::memory_order_relaxed);
+
+    if (position - cached_head == capacity)
+    {
+        cached_head = head.load(std::memory_order_acquire);
+
+        if (position - cached_head == capacity) return nullptr;
+    }
+
+    return &slots[position & index_mask];
+}
+
+template <typename dataType, size_t capacity>
+inline void spscQueue<dataType, capacity>::publish() noexcept
+{
+    tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+template <typename dataType, size_t capacity>
+inline bool spscQueue<dataType, capacity>::try_push(const dataType& element)
+{
+    dataType* slot = write_slot();
+
+    if (slot == nullptr) return false;
+
+    *slot = element;
+
+    publish();
+
+    return true;
+}
+
+template <typename dataType, size_t capacity>
+inline dataType* spscQueue<dataType, capacity>::front() noexcept
+{
+    size_t position = head.load(std::memory_order_relaxed);
+
+    if (position == cached_tail)
+    {
+        cached_tail = tail.load(std::memory_order_acquire);
+
+        if (position == cached_tail) return nullptr;
+    }
+
+    return &slots[position & index_mask];
+}
+
+template <typename dataType, size_t capacity>
+inline void spscQueue<dataType, capacity>::pop() noexcept
+{
+    head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+template <typename dataType, size_t capacity>
+inline bool spscQueue<dataType, capacity>::try_pop(dataType& element)
+{
+    dataType* slot = front();
+
+    if (slot == nullptr) return false;
+
+    std::swap(element, *slot); //the slot keeps whatever element held so its storage gets reused
+
+    pop();
+
+    return true;
+}
+
+template <typename dataType, size_t capacity>
+inline size_t spscQueue<dataType, capacity>::size() const noexcept
+{
+    size_t read_position = head.load(std::memory_order_acquire);
+    size_t write_position = tail.load(std::memory_order_acquire);
+
+    return write_position - read_position; //head is read first so it can never be ahead of the tail that is read after it
+}
+
+template <typename dataType, size_t capacity>
+spscQueue<dataType, capacity>& spscQueue<dataType, capacity>::operator=(const spscQueue& other)
+{
+    throw std::runtime_error("spscQueue type doesn't support item assignment.");
+}
+
+#endif
@@ -0,0 +1,113 @@
+
+//counters and latency histograms that can be read from a monitoring thread without locks
+
+#ifndef STAT_UTILS_H
+#define STAT_UTILS_H
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#define STAT_UTILS_HISTOGRAM_BUCKETS 32
+
+//nanoseconds from the monotonic clock - used to time latencies
+inline int64_t steadyNanoseconds() noexcept
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+a counter with a single writer that can be read from any thread
+writes are a relaxed load and store instead of a locked read-modify-write since only one thread ever updates the counter
+*/
+class statCounter
+{
+public:
+	inline void add(const uint64_t amount) noexcept { value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed); }
+	inline void set(const uint64_t amount) noexcept { value.store(amount, std::memory_order_relaxed); }
+	inline uint64_t get() const noexcept { return value.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<uint64_t> value{ 0 };
+};
+
+/*
+a fixed bucket latency histogram with a single writer
+bucket i counts samples in [2^i, 2^(i + 1)) nanoseconds - bucket 0 also counts 0 ns and the last bucket counts everything above 2^31 ns
+*/
+class latencyHistogram
+{
+public:
+	inline void record(const int64_t nanoseconds) noexcept
+	{
+		uint64_t sample = nanoseconds > 0 ? static_cast<uint64_t>(nanoseconds) : 0;
+		size_t index = std::bit_width(sample | 1) - 1;
+
+		if (index >= STAT_UTILS_HISTOGRAM_BUCKETS) index = STAT_UTILS_HISTOGRAM_BUCKETS - 1;
+
+		buckets[index].add(1);
+		samples.add(1);
+		total.add(sample);
+
+		if (sample > maximum.get()) maximum.set(sample);
+	}
+
+	constexpr inline size_t bucket_count() const noexcept { return STAT_UTILS_HISTOGRAM_BUCKETS; }
+	constexpr inline uint64_t bucket_upper_bound(const size_t index) const noexcept { return (2ULL << index) - 1; } //largest latency counted by a bucket
+
+	inline uint64_t bucket(const size_t index) const noexcept { return buckets[index].get(); }
+	inline uint64_t count() const noexcept { return samples.get(); }
+	inline uint64_t max() const noexcept { return maximum.get(); }
+	inline uint64_t mean() const noexcept { return samples.get() ? total.get() / samples.get() : 0; }
+
+	//upper bound (in nanoseconds) of the bucket that contains the given percentile (0.0 - 1.0)
+	inline uint64_t percentile(const double fraction) const noexcept
+	{
+		uint64_t target = static_cast<uint64_t>(fraction * samples.get());
+		uint64_t seen = 0;
+
+		for (size_t index = 0; index < STAT_UTILS_HISTOGRAM_BUCKETS; ++index)
+		{
+			seen += buckets[index].get();
+
+			if (seen > target) return bucket_upper_bound(index);
+		}
+
+		return maximum.get();
+	}
+
+private:
+	statCounter buckets[STAT_UTILS_HISTOGRAM_BUCKETS];
+	statCounter samples;
+	statCounter total;
+	statCounter maximum;
+};
+
+/*
+statistics kept by every socket
+totals cover the lifetime of the socket object (across reconnects) and are updated only by the thread that uses the socket
+*/
+struct socketStats
+{
+	statCounter bytes_read;
+	statCounter bytes_written;
+	statCounter read_calls;
+	statCounter write_calls;
+	statCounter want_read; //reads that returned without data (SSL_ERROR_WANT_READ)
+	statCounter want_write; //writes that returned without sending (SSL_ERROR_WANT_WRITE)
+	statCounter reconnects; //number of times an open connection was replaced by reInit
+
+	statCounter idle_spins; //empty reads retried straight away by the wait strategy
+	statCounter idle_pauses; //empty reads followed by a batch of pause instructions
+	statCounter idle_blocks; //empty reads followed by a poll
+
+	statCounter connect_ns; //duration of the last tcp connect
+	statCounter handshake_ns; //duration of the last tls handshake
+
+	latencyHistogram read_to_message; //websocket - time from reading the frame header to receiving the full message
+	latencyHistogram request_to_response; //http - time from sending the request to receiving the full response
+};
+
+#endif
@@ -47,6 +47,7 @@ public:
 
     constexpr inline valueDataType& operator[](const keyDataType& key);
     constexpr inline bool contains(const keyDataType& key);
+    constexpr inline valueDataType* find(const keyDataType& key); //same lookup as the [] operator but returns nullptr instead of throwing for a missing key
 
     //groups the keys with the same hash values for easier access
     //takes any container that can be iterated with a range-based for loop
@@ -98,6 +99,19 @@ constexpr inline bool staticUnorderedMap<keyDataType, valueDataType, N, B>::cont
     return false;
 }
 
+template <typename keyDataType, typename valueDataType, size_t N, size_t B>
+constexpr inline valueDataType* staticUnorderedMap<keyDataType, valueDataType, N, B>::find(const keyDataType& key)
+{
+    size_t hash_value = hash<keyDataType>(key) % B;
+
+    for (size_t index = 0; index < bin_sizes[hash_value]; ++index)
+    {
+        if (key == keys[bin_indices[hash_value] + index]) return values + bin_indices[hash_value] + index;
+    }
+
+    return nullptr;
+}
+
 template <typename keyDataType, typename valueDataType, size_t N, size_t B>
 inline void staticUnorderedMap<keyDataType, valueDataType, N, B>::initializeKeys(auto& range_based_container)
 {
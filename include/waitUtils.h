@@ -0,0 +1,143 @@
+
+//wait strategies for non-blocking reads - busy-poll while data is likely to arrive, back off with cpu pause instructions, and then block in poll
+
+#ifndef WAIT_UTILS_H
+#define WAIT_UTILS_H
+
+#define WAIT_UTILS_SPIN_NS 50000 //default strategy - busy-poll for 50us after the last read that returned data
+#define WAIT_UTILS_PAUSE_NS 1000000 //then back off with pause instructions for another 1ms
+#define WAIT_UTILS_BLOCK_MS 1 //then block in poll for up to this many milliseconds per wait
+#define WAIT_UTILS_MAX_PAUSES 64 //the pause instructions per wait double up to this many during the backoff
+
+#include "statUtils.h"
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86) || defined(_M_ARM64))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+//tell the cpu this is a spin loop - frees the core for its hyperthread sibling and avoids the memory order flush when the loop exits
+inline void cpuRelax() noexcept
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+
+	_mm_pause();
+
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+
+	__yield();
+
+#elif defined(__x86_64__) || defined(__i386__)
+
+	_mm_pause();
+
+#elif defined(__aarch64__) || defined(__arm__)
+
+	asm volatile("yield" ::: "memory");
+
+#else
+
+	std::this_thread::yield();
+
+#endif
+}
+
+enum class waitPhase { SPIN, PAUSE, BLOCK };
+
+/*
+decides what a reader does after a non-blocking read returns nothing
+
+the idle time is measured from the first empty read after the last read that returned data
+while it is under spin_ns the reader retries straight away, for the next pause_ns it executes a growing batch of pause instructions between retries ...
+... and after that it blocks in poll for up to block_ms at a time - poll returns as soon as the socket is readable so blocking costs a wakeup, not block_ms
+the socket calls reset whenever a read returns data, so a busy connection never leaves the spin phase
+
+busyPoll never gives up the core (latency critical feeds on a pinned thread), blocking polls straight away (slow rest polls) ...
+... and the default spins briefly before falling back to poll
+*/
+class waitStrategy
+{
+public:
+	waitStrategy() noexcept; //WAIT_UTILS_SPIN_NS, WAIT_UTILS_PAUSE_NS, WAIT_UTILS_BLOCK_MS
+	waitStrategy(const int64_t, const int64_t, const int); //spin ns, pause ns, block ms
+
+	static waitStrategy busyPoll() noexcept;
+	static waitStrategy adaptive() noexcept;
+	static waitStrategy blocking(const int); //block ms
+
+	inline void reset() noexcept { idle_since_ns = 0; pause_batch = 1; }
+
+	waitPhase next() noexcept; //call after a read returned nothing - spins or pauses in place, BLOCK means the caller should poll for block_ms
+
+	inline int64_t spin_ns() const noexcept { return spin_budget_ns; }
+	inline int64_t pause_ns() const noexcept { return pause_budget_ns; }
+	inline int block_ms() const noexcept { return block_timeout_ms; }
+
+private:
+	int64_t spin_budget_ns;
+	int64_t pause_budget_ns;
+	int block_timeout_ms;
+
+	int64_t idle_since_ns = 0;
+	int pause_batch = 1;
+};
+
+inline waitStrategy::waitStrategy() noexcept : spin_budget_ns(WAIT_UTILS_SPIN_NS), pause_budget_ns(WAIT_UTILS_PAUSE_NS), block_timeout_ms(WAIT_UTILS_BLOCK_MS) {}
+
+inline waitStrategy::waitStrategy(const int64_t spin_ns, const int64_t pause_ns, const int block_ms)
+	: spin_budget_ns(spin_ns), pause_budget_ns(pause_ns), block_timeout_ms(block_ms)
+{
+	if (spin_ns < 0 || pause_ns < 0) throw std::runtime_error("Wait strategy budgets cannot be negative.");
+
+	//a reader blocked forever could never time out, send a heartbeat, or notice it was asked to stop
+	if (block_ms <= 0) throw std::runtime_error("Wait strategy must block for at least one millisecond at a time.");
+}
+
+inline waitStrategy waitStrategy::busyPoll() noexcept
+{
+	waitStrategy strategy;
+
+	strategy.spin_budget_ns = std::numeric_limits<int64_t>::max();
+
+	return strategy;
+}
+
+inline waitStrategy waitStrategy::adaptive() noexcept
+{
+	return waitStrategy();
+}
+
+inline waitStrategy waitStrategy::blocking(const int block_ms)
+{
+	return waitStrategy(0, 0, block_ms);
+}
+
+inline waitPhase waitStrategy::next() noexcept
+{
+	const int64_t now = steadyNanoseconds();
+
+	if (!idle_since_ns) idle_since_ns = now;
+
+	const int64_t idle_ns = now - idle_since_ns;
+
+	if (idle_ns < spin_budget_ns) return waitPhase::SPIN;
+
+	if (idle_ns - spin_budget_ns < pause_budget_ns)
+	{
+		for (int pause = 0; pause < pause_batch; ++pause) cpuRelax();
+
+		if (pause_batch < WAIT_UTILS_MAX_PAUSES) pause_batch *= 2;
+
+		return waitPhase::PAUSE;
+	}
+
+	return waitPhase::BLOCK;
+}
+
+#endif
@@ -1,18 +1,62 @@
 
 #include "wsUtils.h"
 
-constexpr char constructBaseFrame(const uint8_t fin, const uint8_t rsv1, const uint8_t rsv2, const uint8_t rsv3, const uint8_t opcode)
-{
-	return static_cast<char>(fin << 7 | rsv1 << 6 | rsv2 << 5 | rsv3 << 4 | opcode);
-}
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
 
-constexpr char constructBaseFrame(const uint8_t fin, const uint8_t opcode)
+//xor the payload with the mask key 32, 16, or 8 bytes at a time - every step is a multiple of 4 bytes so the key stays lined up with the payload
+static void maskPayload(char* destination, const char* source, const size_t length, const unsigned char* mask_key)
 {
-	return static_cast<char>(fin << 7 | opcode);
+	uint32_t key_32;
+	memcpy(&key_32, mask_key, 4);
+
+	uint64_t key_64 = static_cast<uint64_t>(key_32) << 32 | key_32;
+	size_t index = 0;
+
+#if defined(__AVX2__)
+
+	const __m256i key_256 = _mm256_set1_epi32(static_cast<int>(key_32));
+
+	for (; index + 32 <= length; index += 32)
+	{
+		__m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + index));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + index), _mm256_xor_si256(chunk, key_256));
+	}
+
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+	const __m128i key_128 = _mm_set1_epi32(static_cast<int>(key_32));
+
+	for (; index + 16 <= length; index += 16)
+	{
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + index));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + index), _mm_xor_si128(chunk, key_128));
+	}
+
+#endif
+
+	for (; index + 8 <= length; index += 8)
+	{
+		uint64_t chunk;
+
+		memcpy(&chunk, source + index, 8);
+		chunk ^= key_64;
+		memcpy(destination + index, &chunk, 8);
+	}
+
+	for (; index < length; ++index) destination[index] = static_cast<char>(source[index] ^ mask_key[index % 4]);
 }
 
 websocket::websocket(const SSLContextWrapper& ssl_context_wrapper, const std::string Host, const bool blocking, const bool Signal_on_control, const time_t Timeout)
-	: SSLSocket(ssl_context_wrapper, Host, blocking), opened(false), signal_on_control(Signal_on_control), timeout(Timeout)
+	: websocket(ssl_context_wrapper, Host, "443", socketTransport::TLS, blocking, Signal_on_control, Timeout) {}
+
+websocket::websocket(const SSLContextWrapper& ssl_context_wrapper, const std::string Host, const std::string Port, const socketTransport Transport,
+	const bool blocking, const bool Signal_on_control, const time_t Timeout)
+	: SSLSocket(ssl_context_wrapper, Host, Port, Transport, blocking), opened(false), signal_on_control(Signal_on_control), timeout(Timeout),
+	offer_deflate(false), request_msgpack(false), per_message_deflate(false), deflate_no_context_takeover(false), inflater(ZLIB_UTILS_RAW_DEFLATE)
 {
 	frame_header = 0;
 	mask_and_length = 0;
@@ -21,6 +65,45 @@ websocket::websocket(const SSLContextWrapper& ssl_context_wrapper, const std::st
 
 	message_length = 0;
 	bytes_recv = 0;
+
+	message_kernel_ns = 0;
+	message_user_ns = 0;
+	message_complete_ns = 0;
+
+	buffer_start = 0;
+	buffer_end = 0;
+
+	fill_kernel_ns = 0;
+	fill_user_ns = 0;
+
+	message_start_ns = 0;
+	fragment_opcode = 0;
+	message_compressed = false;
+
+	capture = nullptr;
+
+	pings_sent = 0;
+	pongs_sent = 0;
+
+	pong_pending = false;
+
+	ping_interval_ns = 0;
+	stale_after_ns = 0;
+	next_ping_ns = 0;
+	last_traffic_ns = 0;
+	last_ping_ns = 0;
+	last_rtt_ns = 0;
+
+	stale = false;
+
+	large_message.reserve(WS_UTILS_BUFFER_SIZE);
+
+	send_buffer.resize(WS_UTILS_SEND_BUFFER_SIZE);
+
+	//seed the mask key generator once instead of constructing a random device for every message
+	std::random_device random_gen;
+
+	mask_state = (static_cast<uint64_t>(random_gen()) << 32 | random_gen()) | 1;
 }
 
 websocket::~websocket()
@@ -37,177 +120,510 @@ websocket::~websocket()
 	}
 }
 
-int websocket::send(const std::string& message, const char header)
+void websocket::setPerMessageDeflate(const bool offer)
+{
+	offer_deflate = offer;
+}
+
+void websocket::setMsgPack(const bool request)
+{
+	request_msgpack = request;
+}
+
+void websocket::setCapture(captureWriter* writer) noexcept
+{
+	capture = writer;
+}
+
+void websocket::setHeartbeat(const int ping_interval_ms, const int stale_after_ms)
+{
+	ping_interval_ns = ping_interval_ms > 0 ? ping_interval_ms * 1000000LL : 0;
+	stale_after_ns = stale_after_ms > 0 ? stale_after_ms * 1000000LL : 0;
+
+	if (opened) startHeartbeat();
+}
+
+bool websocket::is_stale() const noexcept
+{
+	return stale;
+}
+
+int64_t websocket::ping_rtt_ns() const noexcept
+{
+	return last_rtt_ns;
+}
+
+void websocket::heartbeat()
+{
+	if (pong_pending || ping_interval_ns) serviceHeartbeat();
+	if (stale_after_ns && !wait_readable(0)) checkStale();
+}
+
+void websocket::startHeartbeat()
+{
+	int64_t now = steadyNanoseconds();
+
+	next_ping_ns = now + ping_interval_ns;
+	last_traffic_ns = now;
+
+	if (is_blocking()) setReadTimeout(ping_interval_ns || stale_after_ns ? WS_UTILS_HEARTBEAT_CHECK_MS : 0);
+}
+
+void websocket::serviceHeartbeat()
+{
+	time_t recv_started = sec_since_epoch; //send restarts the clock recv's timeout is measured from
+
+	if (pong_pending)
+	{
+		pong_pending = false;
+
+		if (!send(pending_pong, WS_PONG_FRAME)) throw std::runtime_error("Failed to send pong message.");
+
+		++pongs_sent;
+	}
+
+	if (ping_interval_ns)
+	{
+		int64_t now = steadyNanoseconds();
+
+		if (now >= next_ping_ns)
+		{
+			//the pong echoes the send time back so the round trip can be measured
+			last_ping_ns = now;
+
+			send(std::string_view(reinterpret_cast<const char*>(&last_ping_ns), sizeof(last_ping_ns)), WS_PING_FRAME);
+
+			//keep to the interval unless recv was not called for a whole interval
+			next_ping_ns += ping_interval_ns;
+
+			if (next_ping_ns <= now) next_ping_ns = now + ping_interval_ns;
+
+			++pings_sent;
+		}
+	}
+
+	sec_since_epoch = recv_started;
+}
+
+void websocket::checkStale()
+{
+	if (steadyNanoseconds() - last_traffic_ns <= stale_after_ns) return;
+
+	stale = true;
+	opened = false; //the connection is dead so don't try to send a close frame
+
+	throw SSLNoReturn("Nothing was received on the websocket before the heartbeat deadline.");
+}
+
+uint32_t websocket::nextMaskKey() noexcept
 {
-	std::string new_message(1, header);
+	mask_state ^= mask_state >> 12;
+	mask_state ^= mask_state << 25;
+	mask_state ^= mask_state >> 27;
+
+	return static_cast<uint32_t>(mask_state * 0x2545F4914F6CDD1DULL >> 32);
+}
 
+int websocket::send(const std::string_view message, const char header)
+{
 	//int mask = 1 //all outgoing messages will be masked
 
 	size_t length = message.size();
+	size_t header_length = length < 0x7e ? 6 : length < 0x10000 ? 8 : 14; //the last 4 bytes of the header are the mask key
 	size_t delivered = 0;
 
-	if (length < 0x7e) new_message += char(WS_SMALL_MESSAGE_MASK_BYTE | length); //mask << 7 = 128
+	if (send_buffer.size() < header_length + length) send_buffer.resize(header_length + length);
+
+	char* frame = &send_buffer[0];
+
+	frame[0] = header;
+
+	//lengths are written byte by byte in network byte order
+	if (length < 0x7e) frame[1] = char(WS_SMALL_MESSAGE_MASK_BYTE | length); //mask << 7 = 128
 	else if (length < 0x10000)
 	{
-		new_message += WS_MESSAGE_MASK_CHAR;
-
-		uint16_t length_16 = TO_NETWORK_BYTE_ORDER_16(static_cast<uint16_t>(length));
-		new_message += std::string(reinterpret_cast<const char*>(&length_16), 2);
+		frame[1] = WS_MESSAGE_MASK_CHAR;
+		frame[2] = static_cast<char>(length >> 8);
+		frame[3] = static_cast<char>(length);
 	}
 	else
 	{
-		new_message += WS_LARGE_MESSAGE_MASK_CHAR;
+		frame[1] = WS_LARGE_MESSAGE_MASK_CHAR;
 
-		uint64_t length_64 = TO_NETWORK_BYTE_ORDER_64(static_cast<uint64_t>(length));
-		new_message += std::string(reinterpret_cast<const char*>(&length_64), 8);
+		for (size_t index = 0; index < 8; ++index) frame[2 + index] = static_cast<char>(static_cast<uint64_t>(length) >> (56 - 8 * index));
 	}
 
-	std::random_device random_gen;
-	std::generate_n(&mask_key[0], 4, [&random_gen] { return random_gen() % 256; });
+	uint32_t key = nextMaskKey();
 
-	new_message += std::string(reinterpret_cast<const char*>(mask_key), 4);
+	memcpy(mask_key, &key, 4);
+	memcpy(frame + header_length - 4, mask_key, 4);
 
-	for (size_t i = 0; i < length; ++i) new_message += static_cast<char>(message[i] ^ mask_key[i % 4]);
+	maskPayload(frame + header_length, message.data(), length, mask_key);
 
-	length = new_message.size();
+	length += header_length;
 	sec_since_epoch = time(nullptr);
 
 	while (delivered < length)
 	{
-		delivered += write(new_message.substr(delivered, length - delivered));
+		delivered += write(frame + delivered, static_cast<int>(length - delivered));
 
 		if (time(nullptr) - sec_since_epoch >= timeout) throw exceptions::exception("Timed out while sending a websocket message.");
 	}
 
-	return length;
+	return static_cast<int>(length);
 }
 
-bool websocket::recv(std::string& message)
+size_t websocket::fill()
 {
-	message.clear();
+	if (buffer_start == buffer_end) buffer_start = buffer_end = 0;
+	else if (buffer_start && WS_UTILS_BUFFER_SIZE - buffer_end < WS_UTILS_MIN_READ_SIZE)
+	{
+		memmove(message_buffer, message_buffer + buffer_start, buffer_end - buffer_start);
 
-	//NOTE - For fragmented messages FIN = 1 only on the last frame and opcode = 0x0 on all but the first frame.
-	//NOTE - Clients and servers MUST support receiving both fragmented and unfragmented messages (which I currently do not).
-	//NOTE - messages split into multiple frames can only be interrupted by control frames (ping, pong, and close)
+		buffer_end -= buffer_start;
+		buffer_start = 0;
+	}
 
-	bytes_recv = read(&frame_header, 1);
+	if (pong_pending || ping_interval_ns) serviceHeartbeat();
 
-	if (bytes_recv == 0) return false;
-	else if (frame_header != WS_TEXT_FRAME && frame_header != WS_BINARY_FRAME && frame_header != WS_PING_FRAME)
-	{
-		throw std::runtime_error(("Incoming websocket message has an unexpected frame header: <" + std::string(&frame_header, 1) + ">").c_str());
-	}
+	bytes_recv = read(message_buffer + buffer_end, WS_UTILS_BUFFER_SIZE - buffer_end);
 
-	sec_since_epoch = time(nullptr);
+	//staleness is only judged after a read finds nothing so a consumer that fell behind never mistakes its own delay for a dead connection
+	if (!bytes_recv && stale_after_ns) checkStale();
 
-	do
+	if (bytes_recv)
 	{
-		bytes_recv = read(&mask_and_length, 1);
+		buffer_end += bytes_recv;
 
-		if (time(nullptr) - sec_since_epoch >= timeout) throw exceptions::exception("Timed out while reading a websocket message0.");
+		if (stale_after_ns) last_traffic_ns = steadyNanoseconds();
+
+		fill_kernel_ns = get_kernel_recv_ns();
+		fill_user_ns = get_user_recv_ns();
 	}
-	while (bytes_recv == 0);
 
-	if (bytes_recv == -1) throw std::runtime_error("SSL error occured.");
+	return bytes_recv;
+}
+
+size_t websocket::parseFrameHeader()
+{
+	size_t available = buffer_end - buffer_start;
 
-	//bool has_mask = mask_and_length >> 7 & 1;
+	if (available < 2) return 0;
 
-	if (mask_and_length >> 7 & 1) throw std::runtime_error("Incoming websocket messages should not be masked for this specific application.");
+	const unsigned char* header = reinterpret_cast<const unsigned char*>(message_buffer + buffer_start);
 
-	message_length = mask_and_length & 0x7f & 0x7f;
-	sec_since_epoch = time(nullptr);
-	bytes_recv = 0; //use bytes_recv to count the total number of bytes received for the message length
+	frame_header = static_cast<char>(header[0]);
+	mask_and_length = static_cast<char>(header[1]);
+
+	if (header[1] >> 7 & 1) throw std::runtime_error("Incoming websocket messages should not be masked for this specific application.");
+
+	message_length = header[1] & 0x7f;
 
+	//extended payload lengths are in network byte order - assembling them byte by byte works on any system
 	if (message_length == 0x7e)
 	{
-		do
-		{
-			bytes_recv += read(&message_buffer[bytes_recv], 2ULL - bytes_recv); //assumes WS_UTILS_BUFFER_SIZE >= 2
+		if (available < 4) return 0;
 
-			if (time(nullptr) - sec_since_epoch >= timeout) throw exceptions::exception("Timed out while reading a websocket message1.");
-		}
-		while (bytes_recv < 2ULL);
+		message_length = static_cast<size_t>(header[2]) << 8 | header[3];
+
+		return 4;
+	}
+
+	if (message_length == 0x7f)
+	{
+		if (available < 10) return 0;
+
+		message_length = 0;
 
-		message_length = reinterpret_cast<uint16_t&>(message_buffer);
-		message_length = TO_SYSTEM_BYTE_ORDER_16(message_length);
+		for (size_t index = 2; index < 10; ++index) message_length = message_length << 8 | header[index];
+
+		return 10;
 	}
-	else if (message_length == 0x7f)
+
+	return 2;
+}
+
+std::string_view websocket::bufferPayload()
+{
+	//small payloads are completed in message_buffer so the bytes read past them stay buffered for the next frame
+	if (buffer_start + message_length > WS_UTILS_BUFFER_SIZE)
 	{
-		do
-		{
-			bytes_recv += read(&message_buffer[bytes_recv], 8ULL - bytes_recv); //assumes WS_UTILS_BUFFER_SIZE >= 8
+		memmove(message_buffer, message_buffer + buffer_start, buffer_end - buffer_start);
 
-			if (time(nullptr) - sec_since_epoch >= timeout) throw exceptions::exception("Timed out while reading a websocket message2.");
-		}
-		while (bytes_recv < 8ULL);
+		buffer_end -= buffer_start;
+		buffer_start = 0;
+	}
 
-		message_length = reinterpret_cast<uint64_t&>(message_buffer);
-		message_length = TO_SYSTEM_BYTE_ORDER_64(message_length);
+	while (buffer_end - buffer_start < message_length)
+	{
+		if (fill()) sec_since_epoch = time(nullptr);
+		else if (time(nullptr) - sec_since_epoch >= timeout) throw exceptions::exception("Timed out while reading a websocket message1.");
+		else idle();
 	}
-	else if (message_length > 0x7f) throw std::runtime_error("Received an unknown format for the payload length.");
 
-	sec_since_epoch = time(nullptr);
+	std::string_view payload(message_buffer + buffer_start, message_length);
+
+	buffer_start += message_length;
+
+	return payload;
+}
+
+void websocket::appendPayload(std::string& destination)
+{
+	//whatever part of the payload is already buffered is copied and the rest is read straight into destination
+	size_t offset = destination.size();
+	size_t received = std::min(buffer_end - buffer_start, message_length);
+
+	destination.resize(offset + message_length);
+	memcpy(&destination[offset], message_buffer + buffer_start, received);
 
-	total_msg_len = message_length;
+	buffer_start += received;
 
-	while (message_length > WS_UTILS_BUFFER_SIZE)
+	while (received < message_length)
 	{
-		if (time(nullptr) - sec_since_epoch >= timeout) throw exceptions::exception("Timed out while reading a websocket message3.");
+		size_t remaining = message_length - received;
 
-		bytes_recv = read(message_buffer, WS_UTILS_BUFFER_SIZE);
+		bytes_recv = read(&destination[offset + received], remaining < INT_MAX ? static_cast<int>(remaining) : INT_MAX);
 
 		if (bytes_recv)
 		{
-			message += std::string(&message_buffer[0], bytes_recv);
-			message_length -= bytes_recv;
-
+			received += bytes_recv;
 			sec_since_epoch = time(nullptr);
+
+			if (stale_after_ns) last_traffic_ns = steadyNanoseconds();
+		}
+		else
+		{
+			if (stale_after_ns) checkStale();
+			if (time(nullptr) - sec_since_epoch >= timeout) throw exceptions::exception("Timed out while reading a websocket message2.");
+
+			idle();
 		}
 	}
+}
 
-	while (message_length > 0)
-	{
-		if (time(nullptr) - sec_since_epoch >= timeout) throw exceptions::exception("Timed out while reading a websocket message4.");
+bool websocket::recv(std::string_view& message)
+{
+	message = std::string_view();
 
-		bytes_recv = read(message_buffer, message_length);
+	//NOTE - For fragmented messages FIN = 1 only on the last frame and opcode = 0x0 on all but the first frame.
+	//NOTE - messages split into multiple frames can only be interrupted by control frames (ping, pong, and close)
+	//NOTE - fragments are appended to large_message as they arrive and recv keeps reading frames until the final one ...
+	//... unless nothing is available on a non-blocking socket, in which case the partial message is kept for the next call
 
-		if (bytes_recv)
+	while (true)
+	{
+		size_t header_length = parseFrameHeader();
+
+		if (!header_length)
 		{
-			message += std::string(&message_buffer[0], bytes_recv);
-			message_length -= bytes_recv;
+			if (buffer_start == buffer_end && fill() == 0) return false; //nothing was received
 
 			sec_since_epoch = time(nullptr);
+
+			while (!(header_length = parseFrameHeader()))
+			{
+				if (fill()) sec_since_epoch = time(nullptr);
+				else if (time(nullptr) - sec_since_epoch >= timeout) throw exceptions::exception("Timed out while reading a websocket message0.");
+				else idle();
+			}
 		}
-	}
 
-	if (frame_header == WS_PING_FRAME)
-	{
-		if (!send(message, WS_PONG_FRAME)) throw std::runtime_error("Failed to send pong message.");
+		const char opcode = frame_header & WS_OPCODE_BITS;
+		const bool fin = frame_header & WS_FIN_BIT;
+		const bool control = opcode & 0x8;
+
+		//rsv1 marks a compressed message and is only allowed on the first frame of a data message
+		const char rsv_bits = frame_header & (per_message_deflate && (opcode == WS_TEXT_OPCODE || opcode == WS_BINARY_OPCODE) ? WS_RSV_BITS & ~WS_RSV1_BIT : WS_RSV_BITS);
+
+		if (rsv_bits ||
+			(control && opcode != WS_PING_OPCODE && opcode != WS_PONG_OPCODE && opcode != WS_CLOSE_OPCODE) ||
+			(!control && opcode != WS_CONTINUATION_OPCODE && opcode != WS_TEXT_OPCODE && opcode != WS_BINARY_OPCODE))
+		{
+			throw std::runtime_error(("Incoming websocket message has an unexpected frame header: <" + std::string(&frame_header, 1) + ">").c_str());
+		}
+
+		if (control && (!fin || message_length > 0x7d)) throw std::runtime_error("Received a fragmented or oversized websocket control frame.");
+		if (opcode == WS_CONTINUATION_OPCODE && !fragment_opcode) throw std::runtime_error("Received a websocket continuation frame without a message to continue.");
+		if ((opcode == WS_TEXT_OPCODE || opcode == WS_BINARY_OPCODE) && fragment_opcode) throw std::runtime_error("Received a new websocket message before the last fragment of the previous one.");
+
+		//opcode of the whole message - continuation frames take it from the first fragment
+		const char message_opcode = opcode == WS_CONTINUATION_OPCODE ? fragment_opcode : opcode;
+
+		int64_t frame_start_ns = steadyNanoseconds();
+
+		//a fragmented message keeps the timestamps of its first frame
+		if (!fragment_opcode)
+		{
+			message_kernel_ns = fill_kernel_ns;
+			message_user_ns = fill_user_ns;
+			message_start_ns = frame_start_ns;
+		}
+
+		if (!control && opcode != WS_CONTINUATION_OPCODE) message_compressed = frame_header & WS_RSV1_BIT;
+
+		buffer_start += header_length;
+		total_msg_len = message_length;
+		sec_since_epoch = time(nullptr);
+
+		if (opcode == WS_CONTINUATION_OPCODE || (!fin && !control))
+		{
+			if (!fragment_opcode)
+			{
+				fragment_opcode = opcode;
+				large_message.clear();
+			}
+
+			appendPayload(large_message);
+
+			if (!fin) continue;
+
+			fragment_opcode = 0;
+			total_msg_len = large_message.size();
+			message = large_message;
+		}
+		else if (message_length <= WS_UTILS_BUFFER_SIZE / 2) message = bufferPayload();
+		else
+		{
+			large_message.clear();
+			appendPayload(large_message);
+
+			message = large_message;
+		}
+
+		if (!control && message_compressed)
+		{
+			//the sender strips the 0x00 0x00 0xff 0xff that ends every sync flush so it has to be fed back in
+			static const char deflate_trailer[4] = { 0x00, 0x00, static_cast<char>(0xff), static_cast<char>(0xff) };
+
+			inflated_message.clear();
+
+			inflater.inflate(message.data(), message.size(), inflated_message);
+			inflater.inflate(deflate_trailer, 4, inflated_message);
+
+			if (deflate_no_context_takeover) inflater.reset();
+
+			message = inflated_message;
+		}
+
+		if (message_user_ns) message_complete_ns = realtimeNanoseconds();
+
+		get_stats().read_to_message.record(steadyNanoseconds() - (control ? frame_start_ns : message_start_ns));
+
+		//the kernel timestamp is the closest to when the message arrived - the realtime clock is the fallback when timestamps are off
+		if (capture) capture->record(message_kernel_ns ? message_kernel_ns : message_user_ns ? message_user_ns : realtimeNanoseconds(), message_opcode, message);
+
+		if (!control) return true;
 
-		message.clear();
+		if (opcode == WS_PING_OPCODE)
+		{
+			//only the latest ping has to be answered so a queued pong is replaced
+			pending_pong.assign(message.data(), message.size());
+			pong_pending = true;
+		}
+		else if (opcode == WS_PONG_OPCODE)
+		{
+			if (message.size() == sizeof(last_ping_ns) && !memcmp(message.data(), &last_ping_ns, sizeof(last_ping_ns))) last_rtt_ns = steadyNanoseconds() - last_ping_ns;
+		}
+		else if (opcode == WS_CLOSE_OPCODE)
+		{
+			//echo the status code back as the closing handshake requires
+			try { send(message.substr(0, 2), WS_CLOSE_FRAME); }
+			catch (const std::exception&) {}
+
+			opened = false;
+
+			throw SSLNoReturn("The websocket was closed by the server.");
+		}
+
+		message = std::string_view();
 
 		return signal_on_control;
 	}
+}
+
+bool websocket::recv(std::string& message)
+{
+	std::string_view view;
+
+	bool received = recv(view);
 
-	return true;
+	message.assign(view.data(), view.size());
+
+	return received;
 }
 
 void websocket::open(const dictionary& headers, const char* path, http::httpResponse& response)
 {
 	std::string request;
 
-	http::constructRequest(dictionary(), headers, host, path, "GET", request);
+	bool add_deflate = offer_deflate && headers.find("Sec-WebSocket-Extensions") == headers.end();
+	bool add_msgpack = request_msgpack && headers.find("Content-Type") == headers.end();
+
+	if (add_deflate || add_msgpack)
+	{
+		dictionary extended_headers(headers);
+
+		if (add_deflate) extended_headers["Sec-WebSocket-Extensions"] = "permessage-deflate";
+		if (add_msgpack) extended_headers["Content-Type"] = "application/msgpack";
+
+		http::constructRequest(dictionary(), extended_headers, get_host_header(), path, "GET", request);
+	}
+	else http::constructRequest(dictionary(), headers, get_host_header(), path, "GET", request);
+
+	size_t delivered = 0;
+
+	sec_since_epoch = time(nullptr);
+
+	while (delivered < request.size())
+	{
+		delivered += write(request.data() + delivered, static_cast<int>(request.size() - delivered));
+
+		if (time(nullptr) - sec_since_epoch >= timeout) throw exceptions::exception("Timed out while sending the websocket upgrade request.");
+	}
+
+	buffer_start = buffer_end = 0;
+	fragment_opcode = 0;
 
-	SSL_write(ssl_struct, request.c_str(), request.size());
+	per_message_deflate = false;
+	deflate_no_context_takeover = false;
 
 	http::parseResponseHeader(*this, timeout, response);
 
-	if (response.status_code == 101) opened = true;
+	if (response.status_code == 101)
+	{
+		opened = true;
+
+		//header names are matched case insensitively by find
+		std::string_view extensions = response.find("Sec-WebSocket-Extensions");
+
+		if (extensions.find("permessage-deflate") != std::string_view::npos)
+		{
+			per_message_deflate = true;
+			deflate_no_context_takeover = extensions.find("server_no_context_takeover") != std::string_view::npos;
+
+			inflater.reset(); //a new connection starts with an empty window
+		}
+
+		//frames the server sent right after the upgrade may have been read along with the response header
+		if (response.message.size() > WS_UTILS_BUFFER_SIZE) throw exceptions::exception("Received too much data along with the websocket upgrade response.");
+
+		memcpy(message_buffer, response.message.data(), response.message.size());
+
+		buffer_end = response.message.size();
+
+		response.message.clear();
+
+		pong_pending = false;
+		stale = false;
+
+		if (ping_interval_ns || stale_after_ns) startHeartbeat();
+	}
 }
 
 int websocket::close()
 {
-	if (write(WS_CLOSE_MESSAGE))
+	if (send(std::string_view(), WS_CLOSE_FRAME))
 	{
 		opened = false;
 
@@ -6,13 +6,16 @@ this RFC6455 implementation consists only of what I need to handle messages from
 More specifically:
 	It does not explicitly handle all opcode types
 	It does not fully account for protocol violations or unexpected behavior
-	It does not handle additional extensions such as compression
+	It handles permessage-deflate only on receive - compressed messages are inflated with or without context takeover, but sent messages are never compressed
+	Fragmented messages are reassembled before recv returns them
 */
 
 #ifndef WS_UTILS_H
 #define WS_UTILS_H
 
-#define WS_UTILS_BUFFER_SIZE 4096
+#define WS_UTILS_BUFFER_SIZE 32768 //size of the receive buffer - holds several tls records worth of frames
+#define WS_UTILS_MIN_READ_SIZE 4096 //move unparsed bytes to the front of the receive buffer when less than this much space is left at the end
+#define WS_UTILS_HEARTBEAT_CHECK_MS 50 //with the heartbeat on, blocking reads give up this often so pings go out and staleness is noticed
 
 #define IS_LITTLE_ENDIAN 1 //set to 0 if system is big endian
 
@@ -39,29 +42,53 @@ More specifically:
 
 #include <ctime>
 #include <string>
+#include <string_view>
 #include <stdexcept>
 #include <random>
+#include <algorithm>
+#include <cctype>
 
 #include "exceptUtils.h"
 #include "socketUtils.h"
 #include "httpUtils.h"
+#include "zlibUtils.h"
+#include "captureUtils.h"
 
 constexpr uint8_t WS_SMALL_MESSAGE_MASK_BYTE = 1 << 7;
 constexpr char WS_MESSAGE_MASK_CHAR = char(1 << 7 | 0x7e);
 constexpr char WS_LARGE_MESSAGE_MASK_CHAR = char(1 << 7 | 0x7f);
 
-//construct the frame header of the message
-constexpr char constructBaseFrame(const uint8_t, const uint8_t, const uint8_t, const uint8_t, const uint8_t);
-constexpr char constructBaseFrame(const uint8_t, const uint8_t);
+#define WS_UTILS_SEND_BUFFER_SIZE 4096 //initial size of the reusable buffer outgoing frames are built in - it grows to fit the largest frame sent
 
-//evaluate the expected frame headers and the closing frame at runtime since it will be the same in all messages for this application
-const char WS_TEXT_FRAME = constructBaseFrame(1, 0, 0, 0, 0x1); //prints as 
-const char WS_BINARY_FRAME = constructBaseFrame(1, 0, 0, 0, 0x2); //prints as 
-const char WS_PING_FRAME = constructBaseFrame(1, 0, 0, 0, 0x9); //if we receive this frame, respond immediately - prints as 
-const char WS_PONG_FRAME = constructBaseFrame(1, 0, 0, 0, 0xa); //the response frame for ping frames
-const char WS_CLOSE_FRAME = constructBaseFrame(1, 0, 0, 0, 0x8); //closing frame is always the same
+//construct the frame header of the message
+constexpr char constructBaseFrame(const uint8_t fin, const uint8_t rsv1, const uint8_t rsv2, const uint8_t rsv3, const uint8_t opcode)
+{
+	return static_cast<char>(fin << 7 | rsv1 << 6 | rsv2 << 5 | rsv3 << 4 | opcode);
+}
 
-constexpr const char* WS_CLOSE_MESSAGE = "\x88\x00";
+constexpr char constructBaseFrame(const uint8_t fin, const uint8_t opcode)
+{
+	return static_cast<char>(fin << 7 | opcode);
+}
+
+//the expected frame headers and the closing frame are evaluated at compile time since they will be the same in all messages for this application
+constexpr char WS_TEXT_FRAME = constructBaseFrame(1, 0, 0, 0, 0x1); //prints as 
+constexpr char WS_BINARY_FRAME = constructBaseFrame(1, 0, 0, 0, 0x2); //prints as 
+constexpr char WS_PING_FRAME = constructBaseFrame(1, 0, 0, 0, 0x9); //if we receive this frame, respond immediately - prints as 
+constexpr char WS_PONG_FRAME = constructBaseFrame(1, 0, 0, 0, 0xa); //the response frame for ping frames
+constexpr char WS_CLOSE_FRAME = constructBaseFrame(1, 0, 0, 0, 0x8); //closing frame is always the same
+
+constexpr char WS_FIN_BIT = char(1 << 7);
+constexpr char WS_RSV_BITS = 0x70;
+constexpr char WS_RSV1_BIT = 0x40; //set on the first frame of a compressed message when permessage-deflate is in use
+constexpr char WS_OPCODE_BITS = 0x0f;
+
+constexpr char WS_CONTINUATION_OPCODE = 0x0;
+constexpr char WS_TEXT_OPCODE = 0x1;
+constexpr char WS_BINARY_OPCODE = 0x2;
+constexpr char WS_CLOSE_OPCODE = 0x8;
+constexpr char WS_PING_OPCODE = 0x9;
+constexpr char WS_PONG_OPCODE = 0xa;
 
 /*
 a class designed for handling websocket message sending and receiving
@@ -69,12 +96,25 @@ reuses the same char buffers to reduce memory allocations and deallocations
 
 somewhat supports nonblocking I/O - if recv is called and there is a message to be received ...
 ... then the full message will be received before recv returns, otherwise recv returns immediately
+
+recv reads as much as is available into message_buffer and parses frames out of it ...
+... so a burst of small frames costs one read instead of three or more reads per frame
+
+fragmented messages are reassembled into large_message and may be interrupted by ping, pong, and close frames ...
+... a close frame is answered and then recv throws SSLNoReturn
+
+pongs are not sent from inside recv's frame loop - the latest ping's payload is kept and its pong goes out before the next read from the socket
+
+permessage-deflate (RFC 7692) is used whenever the server accepts it in the upgrade response ...
+... compressed messages are inflated into inflated_message by one zlib stream that keeps its window between messages (context takeover) ...
+... unless the server asked for server_no_context_takeover - outgoing messages are never compressed
 */
 
 class websocket : public SSLSocket
 {
 public:
-	websocket(const SSLContextWrapper&, const std::string, const bool, const bool, const time_t);
+	websocket(const SSLContextWrapper&, const std::string, const bool, const bool, const time_t); //tls on port 443
+	websocket(const SSLContextWrapper&, const std::string, const std::string, const socketTransport, const bool, const bool, const time_t); //host, port, transport, ...
 	~websocket();
 
 	/*
@@ -88,12 +128,62 @@ public:
 	int close();
 
 	/*
-	both send and recv assume the system is little endian and the network is big endian
+	send and recv encode and decode payload lengths byte by byte in network byte order so they do not depend on the system byte order
+	*/
+
+	/*
+	offer permessage-deflate in the next open (off by default)
+	passing a Sec-WebSocket-Extensions header to open has the same effect
+	*/
+	void setPerMessageDeflate(const bool);
+
+	/*
+	ask for messagepack instead of json in the next open by sending Content-Type: application/msgpack (off by default)
+	servers that support it (alpaca's data streams) then send binary frames that can be decoded with mpUtils.h
+	*/
+	void setMsgPack(const bool);
+
+	/*
+	record every message recv delivers (reassembled and inflated, control frames included) to the capture writer - nullptr stops recording
+	the writer is not owned and has to outlive the websocket or be detached first
+	*/
+	void setCapture(captureWriter*) noexcept;
+
+	/*
+	ping interval ms (0 never pings), stale after ms (0 never goes stale) - takes effect immediately and for every later open
+	recv sends a ping whenever the interval has passed since the last one and throws SSLNoReturn once nothing at all ...
+	... (messages, pongs, or anything else) has been received for the stale time - the connection is then marked stale and not closed
+	blocking sockets get a WS_UTILS_HEARTBEAT_CHECK_MS read timeout while the heartbeat is on so recv can return false when idle ...
+	... which keeps both checks running on a quiet connection - non-blocking sockets only need recv to be called
+	a stale time of a few ping intervals (for example 200 ms pings and 600 ms stale) detects a dead connection within a second
 	*/
+	void setHeartbeat(const int, const int);
 
-	int send(const std::string&, const char);
+	/*
+	what recv does before each read, for a connection that is not being read right now (a standby) ...
+	... sends the queued pong and a due ping, and throws like recv if the connection went stale with nothing left to read
+	*/
+	void heartbeat();
+
+	bool is_stale() const noexcept; //the heartbeat deadline passed on this connection
+	int64_t ping_rtt_ns() const noexcept; //round trip of the last answered heartbeat ping (0 before the first pong)
+
+	/*
+	frames the message into send_buffer and masks it with a key from a xorshift generator seeded once per websocket ...
+	... so sending allocates nothing once send_buffer has grown to fit the largest frame
+	*/
+	int send(const std::string_view, const char);
 	bool recv(std::string&); //returns true if a message was received - only need to check for non-blocking I/O
 
+	/*
+	same as above but without copying - the view points into message_buffer (or large_message for payloads larger than half of it) ...
+	... and is only valid until the next call to recv
+	*/
+
+	bool recv(std::string_view&);
+
+	inline bool buffered() const noexcept { return buffer_start != buffer_end; } //unparsed bytes are waiting in message_buffer - the next recv parses them before reading
+
 public:
 	bool signal_on_control; //recv returns whatever this flag is set to when a ping frame is received
 	bool opened;
@@ -113,6 +203,71 @@ public:
 	time_t timeout;
 
 	uint64_t total_msg_len;
+
+	/*
+	receive timestamps of the last message (all 0 unless setRecvTimestamps(true) was called before reInit)
+	message_kernel_ns - kernel timestamp of the packet that delivered the frame header
+	message_user_ns - realtime clock when the read that delivered the frame header returned
+	message_complete_ns - realtime clock when the full message was received
+	kernel to user latency is message_user_ns - message_kernel_ns and framing latency is message_complete_ns - message_user_ns
+	*/
+
+	int64_t message_kernel_ns;
+	int64_t message_user_ns;
+	int64_t message_complete_ns;
+
+	bool offer_deflate; //send the permessage-deflate offer in open
+	bool request_msgpack; //ask for messagepack in open
+	bool per_message_deflate; //the server accepted permessage-deflate
+	bool deflate_no_context_takeover; //the server resets its window after every message so ours has to be reset as well
+
+	inflateStream inflater; //total_in and total_out give the compressed and decompressed byte counts
+
+	std::string inflated_message; //reused output buffer for decompressed messages
+
+	captureWriter* capture; //receives a copy of every message when set
+
+	uint64_t pings_sent; //heartbeat pings
+	uint64_t pongs_sent; //answers to the server's pings
+
+private:
+	size_t fill(); //read into the free space of message_buffer - returns the number of bytes read
+	size_t parseFrameHeader(); //parse the frame header at buffer_start - returns the header length or 0 if the header is incomplete
+	std::string_view bufferPayload(); //complete the payload of the current frame in message_buffer
+	void appendPayload(std::string&); //append the payload of the current frame to the string
+
+	size_t buffer_start; //first unparsed byte in message_buffer
+	size_t buffer_end; //one past the last received byte in message_buffer
+
+	std::string large_message; //reused storage for payloads that do not fit in message_buffer and for reassembling fragmented messages
+
+	char fragment_opcode; //opcode of the fragmented message being reassembled - 0 if there is none
+	bool message_compressed; //rsv1 was set on the first frame of the current message
+	int64_t message_start_ns; //steady clock when the first frame of the current message was parsed
+
+	uint32_t nextMaskKey() noexcept; //xorshift64* step
+
+	uint64_t mask_state; //state of the mask key generator - never 0
+	std::string send_buffer; //outgoing frames are built here
+
+	int64_t fill_kernel_ns; //timestamps of the last read into message_buffer
+	int64_t fill_user_ns;
+
+	void serviceHeartbeat(); //send the queued pong and the next ping if one is due
+	void checkStale(); //throw if nothing has been received for the stale time
+	void startHeartbeat(); //reset the deadlines and the read timeout for the current connection
+
+	std::string pending_pong; //payload of the last ping that has not been answered yet
+	bool pong_pending;
+
+	int64_t ping_interval_ns;
+	int64_t stale_after_ns;
+	int64_t next_ping_ns; //steady clock
+	int64_t last_traffic_ns; //steady clock when the last read returned data
+	int64_t last_ping_ns; //steady clock sent as the payload of the last ping
+	int64_t last_rtt_ns;
+
+	bool stale;
 };
 
 //generate the websocket key
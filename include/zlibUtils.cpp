@@ -0,0 +1,110 @@
+#include "zlibUtils.h"
+
+#include <algorithm>
+#include <climits>
+
+inflateStream::inflateStream(const int window_bits) : stream(), stream_end(false), bytes_in(0), bytes_out(0)
+{
+	if (inflateInit2(&stream, window_bits) != Z_OK) throw std::runtime_error("Could not initialize the zlib inflate stream.");
+}
+
+inflateStream::inflateStream(const inflateStream& other_stream)
+{
+	throw std::runtime_error("inflateStream type doesn't support copy construction.");
+}
+
+inflateStream::~inflateStream()
+{
+	inflateEnd(&stream);
+}
+
+inflateStream& inflateStream::operator=(const inflateStream& other_stream)
+{
+	throw std::runtime_error("inflateStream type doesn't support item assignment.");
+}
+
+bool inflateStream::inflate(const char* data, const size_t length, std::string& output)
+{
+	size_t consumed = 0;
+	size_t initial_size = output.size();
+	size_t produced = initial_size;
+
+	int status = Z_OK;
+
+	while (!stream_end)
+	{
+		//resize zero-fills what it exposes, so only a window sized to the input is exposed and the capacity grows geometrically ...
+		//... which keeps inflating in small pieces into one growing string linear
+		if (output.size() - produced < ZLIB_UTILS_MIN_OUTPUT)
+		{
+			size_t window = std::clamp<size_t>((length - consumed) * 4, ZLIB_UTILS_MIN_OUTPUT, ZLIB_UTILS_MAX_WINDOW);
+
+			if (output.capacity() < produced + window) output.reserve(std::max(output.capacity() * 2, produced + window));
+
+			output.resize(produced + window);
+		}
+
+		//zlib counts in unsigned ints so very large inputs and outputs are fed in pieces
+		uInt input_size = static_cast<uInt>(std::min<size_t>(length - consumed, UINT_MAX));
+		uInt output_size = static_cast<uInt>(std::min<size_t>(output.size() - produced, UINT_MAX));
+
+		stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data + consumed));
+		stream.avail_in = input_size;
+		stream.next_out = reinterpret_cast<Bytef*>(&output[produced]);
+		stream.avail_out = output_size;
+
+		status = ::inflate(&stream, Z_SYNC_FLUSH);
+
+		consumed += input_size - stream.avail_in;
+		produced += output_size - stream.avail_out;
+
+		if (status == Z_STREAM_END) stream_end = true;
+		else if (status == Z_BUF_ERROR) //no progress was possible
+		{
+			if (consumed == length) break; //all of the input has been used and the rest of the output needs more input
+		}
+		else if (status != Z_OK)
+		{
+			output.resize(produced);
+
+			throw std::runtime_error(std::string("Could not inflate the compressed data: ") + (stream.msg ? stream.msg : "unknown zlib error"));
+		}
+		else if (consumed == length && stream.avail_out) break; //zlib had space left over so all pending output has been flushed
+	}
+
+	output.resize(produced);
+
+	bytes_in += consumed;
+	bytes_out += produced - initial_size;
+
+	return stream_end;
+}
+
+void inflateStream::reset()
+{
+	if (inflateReset(&stream) != Z_OK) throw std::runtime_error("Could not reset the zlib inflate stream.");
+
+	stream_end = false;
+}
+
+void inflateStream::reset(const int window_bits)
+{
+	if (inflateReset2(&stream, window_bits) != Z_OK) throw std::runtime_error("Could not reset the zlib inflate stream.");
+
+	stream_end = false;
+}
+
+bool inflateStream::finished() const noexcept
+{
+	return stream_end;
+}
+
+uint64_t inflateStream::total_in() const noexcept
+{
+	return bytes_in;
+}
+
+uint64_t inflateStream::total_out() const noexcept
+{
+	return bytes_out;
+}
@@ -0,0 +1,57 @@
+
+//streaming zlib decompression that keeps one z_stream (and its window) alive across messages and responses
+
+#ifndef ZLIB_UTILS_H
+#define ZLIB_UTILS_H
+
+#define ZLIB_UTILS_RAW_DEFLATE -15 //raw deflate data with up to a 32KB window (permessage-deflate and http deflate without a header)
+#define ZLIB_UTILS_AUTO_HEADER 47 //15 + 32 - zlib or gzip data, the header decides which (http content encoding)
+#define ZLIB_UTILS_MIN_OUTPUT 4096 //the output string always has at least this much free space before each call to inflate
+#define ZLIB_UTILS_MAX_WINDOW 1048576 //most output space exposed at once - the string's capacity still grows past it
+
+#include <zlib.h>
+
+#pragma comment(lib, "zlib.lib")
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+/*
+a reusable inflate stream
+
+inflate can be called any number of times with consecutive pieces of the compressed data - the output is appended to the string ...
+... which is grown as needed, so passing the same string (cleared) every time means no allocations once it is large enough
+
+reset drops the window and starts a new stream without freeing and reallocating the zlib state
+*/
+
+class inflateStream
+{
+public:
+	inflateStream(const int); //window bits - ZLIB_UTILS_RAW_DEFLATE or ZLIB_UTILS_AUTO_HEADER
+	inflateStream(const inflateStream&);
+	~inflateStream();
+
+	inflateStream& operator=(const inflateStream&);
+
+	bool inflate(const char*, const size_t, std::string&); //returns true once the end of the compressed stream has been reached
+	void reset();
+	void reset(const int); //reset and switch to other window bits
+
+	bool finished() const noexcept;
+
+	uint64_t total_in() const noexcept; //compressed bytes consumed over the lifetime of the stream
+	uint64_t total_out() const noexcept; //decompressed bytes produced over the lifetime of the stream
+
+private:
+	z_stream stream;
+
+	bool stream_end;
+
+	uint64_t bytes_in;
+	uint64_t bytes_out;
+};
+
+#endif